@@ -0,0 +1,318 @@
+#include "GraphScheduler.h"
+#include "GraphSampler.h"
+#include "TriangleCounter.h"
+#include "UDynGraph.h"
+#include "FlatEdgeSet.h"
+#include "SamplerDriver.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_set>
+#include <unistd.h>
+
+using namespace std;
+
+// Microbenchmarks of the core operations on synthetic graphs (built from a
+// fixed seed, no input files). One TSV line per benchmark: the median and
+// minimum nanoseconds per operation over the repetitions and a checksum of
+// the work done, which must not change between commits unless the results
+// of the operation do.
+
+static int repetitions = 3;
+static string filter;
+
+// Timer of one repetition: setup() is not timed, body() returns the checksum.
+static void bench(const string& name, const string& distribution, size_t size, size_t ops,
+		const function<void()>& setup, const function<double()>& body) {
+	if (!filter.empty() && name.find(filter) == string::npos) {
+		return;
+	}
+	vector<double> nanos;
+	double checksum = 0;
+	for (int rep = 0; rep < repetitions; rep++) {
+		setup();
+		auto begin = chrono::steady_clock::now();
+		checksum = body();
+		auto end = chrono::steady_clock::now();
+		nanos.push_back(chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / (double)ops);
+	}
+	sort(nanos.begin(), nanos.end());
+	cout << name << "\t" << distribution << "\t" << size << "\t" << ops << "\t"
+			<< nanos[nanos.size() / 2] << "\t" << nanos[0] << "\t" << checksum << endl;
+}
+
+// Distinct edges without loops. Endpoints are uniform ("uniform") or drawn
+// with weight (i+1)^-1/(gamma-1), gamma = 2.1, as in the Chung-Lu model
+// ("powerlaw").
+static void make_edges(const string& distribution, int num_nodes, size_t num_edges, mt19937& rng,
+		vector<pair<int,int>>* edges) {
+	vector<double> weights(num_nodes, 1.0);
+	if (distribution == "powerlaw") {
+		for (int i = 0; i < num_nodes; i++) {
+			weights[i] = pow(i + 1.0, -1.0 / 1.1);
+		}
+	}
+	discrete_distribution<int> node(weights.begin(), weights.end());
+	unordered_set<unsigned long long> seen;
+	edges->clear();
+	while (edges->size() < num_edges) {
+		int u = node(rng);
+		int v = node(rng);
+		if (u != v && seen.insert(edge_to_id(u, v)).second) {
+			edges->push_back(make_pair(u, v));
+		}
+	}
+}
+
+// Insertions of the edges, followed by the deletion of a random live edge
+// with prob deletion_rate after each one.
+static void make_stream(const vector<pair<int,int>>& edges, double deletion_rate, mt19937& rng,
+		vector<EdgeUpdate>* updates) {
+	vector<pair<int,int>> live;
+	updates->clear();
+	int time = 0;
+	for (const auto& edge: edges) {
+		EdgeUpdate update = {edge.first, edge.second, ++time, true};
+		updates->push_back(update);
+		live.push_back(edge);
+		if (uniform_01(rng) < deletion_rate) {
+			size_t i = rng() % live.size();
+			swap(live[i], live.back());
+			EdgeUpdate removal = {live.back().first, live.back().second, time, false};
+			updates->push_back(removal);
+			live.pop_back();
+		}
+	}
+}
+
+// Executes the updates with the static type of the sampler, as the drivers
+struct StreamDriver {
+	const vector<EdgeUpdate>* updates;
+
+	template <class Sampler>
+	void run(Sampler* sampler) {
+		for (const auto& update: *updates) {
+			exec_operation(sampler, update);
+		}
+	}
+};
+
+static void bench_graph(const string& distribution, const vector<pair<int,int>>& edges, mt19937& rng) {
+	size_t num_edges = edges.size();
+	vector<pair<int,int>> shuffled(edges);
+	shuffle(shuffled.begin(), shuffled.end(), rng);
+	vector<int> queries(num_edges);
+	for (auto& query: queries) {
+		query = edges[rng() % num_edges].first;
+	}
+
+	UDynGraph* graph = NULL;
+	auto fresh_graph = [&]() {
+		delete graph;
+		graph = new UDynGraph();
+	};
+	auto full_graph = [&]() {
+		fresh_graph();
+		for (const auto& edge: edges) {
+			graph->add_edge(edge.first, edge.second);
+		}
+	};
+	bench("graph_add_edge", distribution, num_edges, num_edges, fresh_graph, [&]() {
+		for (const auto& edge: edges) {
+			graph->add_edge(edge.first, edge.second);
+		}
+		return (double)graph->num_edges();
+	});
+	bench("graph_remove_edge", distribution, num_edges, num_edges, full_graph, [&]() {
+		for (const auto& edge: shuffled) {
+			graph->remove_edge(edge.first, edge.second);
+		}
+		return (double)graph->num_edges();
+	});
+	bench("graph_neighbors", distribution, num_edges, queries.size(), full_graph, [&]() {
+		vector<int> neighbors;
+		double scanned = 0;
+		for (const auto& node: queries) {
+			graph->neighbors(node, &neighbors);
+			scanned += neighbors.size();
+		}
+		return scanned;
+	});
+	delete graph;
+
+	TriangleCounter* counter = NULL;
+	auto fresh_counter = [&]() {
+		delete counter;
+		counter = new TriangleCounter(false);
+	};
+	auto full_counter = [&]() {
+		fresh_counter();
+		for (const auto& edge: edges) {
+			counter->add_edge_sample(edge.first, edge.second);
+		}
+	};
+	bench("counter_add_edge", distribution, num_edges, num_edges, fresh_counter, [&]() {
+		for (const auto& edge: edges) {
+			counter->add_edge_sample(edge.first, edge.second);
+		}
+		return (double)counter->size_sample();
+	});
+	bench("counter_remove_edge", distribution, num_edges, num_edges, full_counter, [&]() {
+		for (const auto& edge: shuffled) {
+			counter->remove_edge_sample(edge.first, edge.second);
+		}
+		return (double)counter->size_sample();
+	});
+	// Triangles closed by the edges of the graph (each counted 3 times)
+	bench("counter_probe", distribution, num_edges, num_edges, full_counter, [&]() {
+		for (const auto& edge: edges) {
+			counter->add_triangles(edge.first, edge.second, 1.0);
+		}
+		return (double)counter->triangles();
+	});
+	delete counter;
+
+	FlatEdgeSet* edge_set = NULL;
+	auto fresh_set = [&]() {
+		delete edge_set;
+		edge_set = new FlatEdgeSet();
+	};
+	auto full_set = [&]() {
+		fresh_set();
+		for (const auto& edge: edges) {
+			edge_set->insert(edge_to_id(edge.first, edge.second));
+		}
+	};
+	bench("edge_set_insert", distribution, num_edges, num_edges, fresh_set, [&]() {
+		for (const auto& edge: edges) {
+			edge_set->insert(edge_to_id(edge.first, edge.second));
+		}
+		return (double)edge_set->size();
+	});
+	bench("edge_set_contains", distribution, num_edges, num_edges, full_set, [&]() {
+		double found = 0;
+		for (size_t i = 0; i < num_edges; i++) {
+			// half of the pairs are edges
+			int v = i % 2 ? shuffled[i].second : shuffled[(i + 1) % num_edges].second;
+			found += shuffled[i].first != v && edge_set->contains(edge_to_id(shuffled[i].first, v));
+		}
+		return found;
+	});
+	bench("edge_set_erase", distribution, num_edges, num_edges, full_set, [&]() {
+		for (const auto& edge: shuffled) {
+			edge_set->erase(edge_to_id(edge.first, edge.second));
+		}
+		return (double)edge_set->size();
+	});
+	delete edge_set;
+}
+
+static void bench_parse(const string& distribution, const vector<EdgeUpdate>& updates) {
+	char file_name[] = "/tmp/triest-bench-XXXXXX";
+	int fd = mkstemp(file_name);
+	if (fd < 0) {
+		cerr << "ERROR cannot create a temporary file" << endl;
+		exit(1);
+	}
+	close(fd);
+	{
+		ofstream out(file_name);
+		for (const auto& update: updates) {
+			out << (update.is_add ? '+' : '-') << " " << update.node_u << " " << update.node_v << " " << update.time << "\n";
+		}
+	}
+	for (int store_time = 0; store_time <= 1; store_time++) {
+		bench(store_time ? "parse_with_time" : "parse", distribution, updates.size(), updates.size(), []() {}, [&]() {
+			GraphScheduler scheduler(file_name, store_time);
+			double sum = 0;
+			while (scheduler.has_next()) {
+				EdgeUpdate update = scheduler.next_update();
+				sum += update.node_u + update.is_add;
+			}
+			return sum;
+		});
+	}
+	remove(file_name);
+}
+
+static void bench_samplers(const string& distribution, const vector<EdgeUpdate>& insertions,
+		const vector<EdgeUpdate>& dynamic, const vector<size_t>& sizes) {
+	TriangleCounter* counter = NULL;
+	GraphSampler* sampler = NULL;
+	const vector<EdgeUpdate>* updates = NULL;
+	// Each sampler is built from a fixed seed, so its checksum (final
+	// estimate) is reproducible
+	auto run = [&](const string& name, size_t size, bool is_dynamic, const function<GraphSampler*()>& make) {
+		updates = is_dynamic ? &dynamic : &insertions;
+		bench("exec_" + name, distribution, size, updates->size(), [&]() {
+			delete sampler;
+			delete counter;
+			counter = new TriangleCounter(false);
+			srand(1);
+			sampler = make();
+		}, [&]() {
+			StreamDriver driver = {updates};
+			run_with_static_type(sampler, driver);
+			return sampler->get_triangle_est();
+		});
+	};
+	for (const auto& size: sizes) {
+		run("reservoir", size, false, [&]() { return new ReservoirSampler(size, false, counter); });
+		run("reservoir_addrem", size, true, [&]() { return new ReservoirAddRemSampler(size, counter); });
+		run("thinkd", size, true, [&]() { return new ThinkDSampler(size, counter); });
+		run("waiting_room", size, false, [&]() { return new WaitingRoomSampler(size, 0.1, counter); });
+		run("coordinated", size, false, [&]() { return new CoordinatedSampler(size, 1, counter); });
+		double p = min(1.0, (double)size / insertions.size());
+		run("fixed_p", size, true, [&]() { return new FixedPSampler(p, false, counter); });
+	}
+	run("exact", dynamic.size(), true, [&]() { return new ExactSampler(false); });
+	delete sampler;
+	delete counter;
+}
+
+int main(int argc, char** argv) {
+	size_t num_edges = 200000;
+	int num_nodes = 20000;
+	vector<size_t> sizes = {1000, 10000, 100000};
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--quick") == 0) {
+			num_edges = 20000;
+			num_nodes = 2000;
+			sizes = {1000, 10000};
+			repetitions = 1;
+		} else if (strcmp(argv[i], "--repetitions") == 0 && i+1 < argc) {
+			repetitions = max(1, atoi(argv[++i]));
+		} else if (strcmp(argv[i], "--filter") == 0 && i+1 < argc) {
+			filter = argv[++i];
+		} else {
+			cerr << "ERROR Bench [--quick (smaller graphs, one repetition)] [--repetitions N (default 3)] [--filter substring of the benchmark names]\n"
+					<< "Prints benchmark, distribution, size (edges, or reservoir size for the samplers), ops, median ns/op, min ns/op, checksum" << endl;
+			exit(1);
+		}
+	}
+
+	cout << "benchmark\tdistribution\tsize\tops\tns_per_op\tns_per_op_min\tchecksum" << endl;
+	for (const string distribution: {"uniform", "powerlaw"}) {
+		mt19937 rng(1);
+		vector<pair<int,int>> edges;
+		make_edges(distribution, num_nodes, num_edges, rng, &edges);
+		vector<EdgeUpdate> insertions, dynamic;
+		make_stream(edges, 0.0, rng, &insertions);
+		make_stream(edges, 0.2, rng, &dynamic);
+
+		bench_graph(distribution, edges, rng);
+		bench_parse(distribution, dynamic);
+		bench_samplers(distribution, insertions, dynamic, sizes);
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "GraphScheduler.h"
+#include "TriangleCounter.h"
+#include "GroundTruth.h"
+
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+
+using namespace std;
+
+// Exact counts of the current graph, written to the ground truth file and
+// printed
+static void write_checkpoint(const unordered_set<unsigned long long>& edge_ids, vector<int>* nodes,
+		bool local, int num_threads, unsigned long long count_op, GroundTruthWriter* out) {
+	vector<pair<int,int>> edges;
+	edges.reserve(edge_ids.size());
+	for (const auto& id: edge_ids) {
+		edges.push_back(make_pair(id / MAX_NUM_NODES, id % MAX_NUM_NODES));
+	}
+	sort(nodes->begin(), nodes->end());
+	GroundTruthRecord record;
+	record.op_count = count_op;
+	count_triangles_exact(edges, *nodes, local, num_threads, &record);
+	if (!out->write(record)) {
+		cerr << "ERROR cannot write the ground truth file" << endl;
+		exit(1);
+	}
+	cout << count_op << "\t" << edges.size() << "\t" << nodes->size() << "\t" << record.triangles << endl;
+}
+
+int main(int argc, char** argv) {
+
+	// Named options, removed from the positional parameters
+	int num_threads = max(1u, thread::hardware_concurrency());
+	bool local = true;
+	int num_positional = 1;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+			num_threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--global") == 0) {
+			local = false;
+		} else {
+			argv[num_positional++] = argv[i];
+		}
+	}
+	argc = num_positional;
+
+	if (argc <= 4) {
+		cerr
+				<< "ERROR Requires 4 parameters. ExactCounting only_add (1=yes,0=no); check_every_num_updates (int); graph-udates.txt; ground-truth-output-file\n"
+				<< "Writes the exact global and local triangle counts every check_every_num_updates updates and at the end of the stream, for RunCounting --truth and RunCountingLocal --truth (same only_add and a multiple of check_every_num_updates as stats / error check frequency).\n"
+				<< "OPTIONS: --threads N (default the number of cores, the memory does not depend on it); --global (only the global counts, for RunCounting)" << endl;
+		exit(1);
+	}
+
+	bool only_add = atoi(argv[1])==1;
+	assert(atoi(argv[1])<=1 && atoi(argv[1])>=0);
+	unsigned long long check_freq = atoll(argv[2]);
+	assert(check_freq > 0);
+	string file_name(argv[3]);
+	GroundTruthWriter out(argv[4]);
+	if (!out.ok()) {
+		cerr << "ERROR cannot write " << argv[4] << endl;
+		exit(1);
+	}
+
+	// Only the edge set and the nodes seen are kept during the stream, the
+	// graph is built at each checkpoint.
+	GraphScheduler scheduler(file_name, false /* not storing time*/);
+	unordered_set<unsigned long long> edge_ids;
+	vector<bool> seen;
+	vector<int> nodes;
+	unsigned long long count_op = 0;
+	cout << "op_count_total\tedges\tnodes\ttriangles" << endl;
+	while (scheduler.has_next()) {
+		EdgeUpdate update = scheduler.next_update();
+		if (only_add && !update.is_add) {
+			break; // ENDS at the first remove
+		}
+		if (update.is_add) {
+			edge_ids.insert(edge_to_id(update.node_u, update.node_v));
+			for (int node: {update.node_u, update.node_v}) {
+				if ((size_t)node >= seen.size()) {
+					seen.resize(max((size_t)node + 1, 2 * seen.size()), false);
+				}
+				if (!seen[node]) {
+					seen[node] = true;
+					nodes.push_back(node);
+				}
+			}
+		} else {
+			edge_ids.erase(edge_to_id(update.node_u, update.node_v));
+		}
+		++count_op;
+		if (count_op % check_freq == 0) {
+			write_checkpoint(edge_ids, &nodes, local, num_threads, count_op, &out);
+		}
+	}
+	if (count_op % check_freq != 0) {
+		write_checkpoint(edge_ids, &nodes, local, num_threads, count_op, &out);
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+#ifndef FLATEDGESET_H_
+#define FLATEDGESET_H_
+
+#include "TriangleCounter.h"
+#include "MemoryUsage.h"
+
+#include <vector>
+
+using namespace std;
+
+// Set of edge ids (edge_to_id, never 0) in a flat open addressing table with
+// linear probing: 8 bytes per slot, at most half of the slots used, and no
+// allocation per edge. Erase shifts back the following entries of the
+// cluster instead of leaving tombstones, so lookups stay short in fully
+// dynamic streams.
+class FlatEdgeSet {
+public:
+	FlatEdgeSet() : keys_(16, 0), size_(0) {
+	}
+
+	inline bool contains(unsigned long long key) const {
+		size_t mask = keys_.size() - 1;
+		for (size_t i = mix64(key) & mask; keys_[i] != 0; i = (i + 1) & mask) {
+			if (keys_[i] == key) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Returns false if the key was already in the set.
+	inline bool insert(unsigned long long key) {
+		assert(key != 0);
+		if (2 * (size_ + 1) > keys_.size()) {
+			grow();
+		}
+		size_t mask = keys_.size() - 1;
+		size_t i = mix64(key) & mask;
+		for (; keys_[i] != 0; i = (i + 1) & mask) {
+			if (keys_[i] == key) {
+				return false;
+			}
+		}
+		keys_[i] = key;
+		size_++;
+		return true;
+	}
+
+	// Returns false if the key was not in the set.
+	inline bool erase(unsigned long long key) {
+		size_t mask = keys_.size() - 1;
+		size_t i = mix64(key) & mask;
+		for (; keys_[i] != key; i = (i + 1) & mask) {
+			if (keys_[i] == 0) {
+				return false;
+			}
+		}
+		// Moves back each following key of the cluster whose home slot is
+		// not between the hole and it
+		for (size_t j = (i + 1) & mask; keys_[j] != 0; j = (j + 1) & mask) {
+			size_t home = mix64(keys_[j]) & mask;
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				keys_[i] = keys_[j];
+				i = j;
+			}
+		}
+		keys_[i] = 0;
+		size_--;
+		return true;
+	}
+
+	// Loads the home slot of the key into the cache ahead of a lookup
+	inline void prefetch(unsigned long long key) const {
+		__builtin_prefetch(&keys_[mix64(key) & (keys_.size() - 1)]);
+	}
+
+	inline size_t size() const {
+		return size_;
+	}
+	inline size_t memory_bytes() const {
+		return vector_bytes(keys_);
+	}
+	// Calls f(key) for each key in the set
+	template <class F>
+	void for_each(F f) const {
+		for (const auto& key: keys_) {
+			if (key != 0) {
+				f(key);
+			}
+		}
+	}
+
+private:
+	void grow() {
+		vector<unsigned long long> old(2 * keys_.size(), 0);
+		old.swap(keys_);
+		size_ = 0;
+		for (const auto& key: old) {
+			if (key != 0) {
+				insert(key);
+			}
+		}
+	}
+
+	vector<unsigned long long> keys_; // 0 is an empty slot, size a power of 2
+	size_t size_;
+};
+
+#endif /* FLATEDGESET_H_ */
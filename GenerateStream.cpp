@@ -0,0 +1,356 @@
+#include "FlatEdgeSet.h"
+#include "TriangleCounter.h"
+
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <deque>
+#include <random>
+
+using namespace std;
+
+// Candidate edges drawn ahead of their insertion (a power of 2)
+#define PIPELINE_DEPTH 16
+// Bytes of output buffered before each write
+#define OUTPUT_BUFFER_SIZE (1<<20)
+// Endpoints drawn for a new edge before giving up (graph too dense)
+#define MAX_ATTEMPTS 1000
+
+enum Model {
+	ERDOS_RENYI, // endpoints uniform
+	CHUNG_LU, // endpoint i with weight (i+1)^-1/(gamma-1): power law degrees
+	COMMUNITIES // planted communities: edges inside a community with prob intra
+};
+
+enum Deletions {
+	NO_DELETIONS,
+	RANDOM_DELETIONS, // after each addition, a random edge with prob rate
+	BATCH_DELETIONS, // every batch additions, a fraction of the edges at once
+	WINDOW_DELETIONS // each edge expires window additions after its own
+};
+
+// Uniform in [0, n) for n < 2^32, by multiply and shift (no division)
+static inline unsigned int uniform_below(mt19937_64& rng, unsigned long long n) {
+	return ((rng() >> 32) * n) >> 32;
+}
+
+static inline double uniform_01_64(mt19937_64& rng) {
+	return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Walker's alias method: O(1) draws from a discrete distribution, with the
+// probability and the alias of a slot side by side (one cache miss per draw)
+class AliasTable {
+public:
+	explicit AliasTable(const vector<double>& weights) : slots_(weights.size()) {
+		size_t n = weights.size();
+		double total = 0;
+		for (const auto& weight: weights) {
+			total += weight;
+		}
+		vector<double> scaled(n);
+		vector<int> small, large;
+		for (size_t i = 0; i < n; i++) {
+			scaled[i] = weights[i] * n / total;
+			(scaled[i] < 1.0 ? small : large).push_back(i);
+		}
+		while (!small.empty() && !large.empty()) {
+			int s = small.back();
+			small.pop_back();
+			int l = large.back();
+			slots_[s].prob = scaled[s];
+			slots_[s].alias = l;
+			scaled[l] -= 1.0 - scaled[s];
+			if (scaled[l] < 1.0) {
+				large.pop_back();
+				small.push_back(l);
+			}
+		}
+		for (const auto& i: small) {
+			slots_[i].prob = 1.0;
+			slots_[i].alias = i;
+		}
+		for (const auto& i: large) {
+			slots_[i].prob = 1.0;
+			slots_[i].alias = i;
+		}
+	}
+
+	// A draw in two steps, to prefetch the slot in between
+	inline unsigned int draw_slot(mt19937_64& rng) const {
+		unsigned int i = uniform_below(rng, slots_.size());
+		__builtin_prefetch(&slots_[i]);
+		return i;
+	}
+	inline int resolve(unsigned int i, double coin) const {
+		return coin < slots_[i].prob ? i : slots_[i].alias;
+	}
+
+private:
+	struct Slot {
+		double prob;
+		int alias;
+	};
+	vector<Slot> slots_;
+};
+
+// Candidate edges of the model, drawn PIPELINE_DEPTH candidates ahead: the
+// alias slots (Chung-Lu) are prefetched when a candidate is drawn, its slot in
+// the edge set PIPELINE_DEPTH/2 candidates later, so that with large graphs
+// the memory latency is hidden. The candidates depend only on the seed.
+class CandidateStream {
+public:
+	CandidateStream(Model model, long long num_nodes, double gamma, int community_size, double intra,
+			mt19937_64* rng, const FlatEdgeSet* present) :
+			model_(model), num_nodes_(num_nodes), intra_(intra), rng_(*rng), present_(present),
+			chung_lu_(power_law_weights(model == CHUNG_LU ? num_nodes : 1, gamma)), position_(0) {
+		num_communities_ = max(1LL, num_nodes / community_size);
+		for (int i = 0; i < PIPELINE_DEPTH; i++) {
+			draw(&ring_[i]);
+		}
+		for (int i = 0; i < PIPELINE_DEPTH / 2; i++) {
+			resolve(&ring_[i]);
+		}
+	}
+
+	// Next candidate, possibly a loop or an edge already in the graph
+	inline pair<int,int> next() {
+		Candidate& candidate = ring_[position_];
+		pair<int,int> edge(candidate.u, candidate.v);
+		draw(&candidate);
+		resolve(&ring_[(position_ + PIPELINE_DEPTH / 2) % PIPELINE_DEPTH]);
+		position_ = (position_ + 1) % PIPELINE_DEPTH;
+		return edge;
+	}
+
+private:
+	// Endpoints, alias slots with their coins until resolved for Chung-Lu
+	struct Candidate {
+		unsigned int u, v;
+		double coin_u, coin_v;
+	};
+
+	static vector<double> power_law_weights(long long num_nodes, double gamma) {
+		vector<double> weights(num_nodes);
+		for (long long i = 0; i < num_nodes; i++) {
+			weights[i] = pow(i + 1.0, -1.0 / (gamma - 1));
+		}
+		return weights;
+	}
+
+	inline void draw(Candidate* candidate) {
+		if (model_ == CHUNG_LU) {
+			candidate->u = chung_lu_.draw_slot(rng_);
+			candidate->v = chung_lu_.draw_slot(rng_);
+			candidate->coin_u = uniform_01_64(rng_);
+			candidate->coin_v = uniform_01_64(rng_);
+		} else if (model_ == COMMUNITIES && uniform_01_64(rng_) < intra_) {
+			long long community = uniform_below(rng_, num_communities_);
+			long long first = community * num_nodes_ / num_communities_;
+			long long size = (community + 1) * num_nodes_ / num_communities_ - first;
+			candidate->u = first + uniform_below(rng_, size);
+			candidate->v = first + uniform_below(rng_, size);
+		} else {
+			candidate->u = uniform_below(rng_, num_nodes_);
+			candidate->v = uniform_below(rng_, num_nodes_);
+		}
+	}
+
+	inline void resolve(Candidate* candidate) {
+		if (model_ == CHUNG_LU) {
+			candidate->u = chung_lu_.resolve(candidate->u, candidate->coin_u);
+			candidate->v = chung_lu_.resolve(candidate->v, candidate->coin_v);
+		}
+		if (candidate->u != candidate->v) {
+			present_->prefetch(edge_to_id(candidate->u, candidate->v));
+		}
+	}
+
+	Model model_;
+	long long num_nodes_;
+	long long num_communities_;
+	double intra_;
+	mt19937_64& rng_;
+	const FlatEdgeSet* present_;
+	AliasTable chung_lu_;
+	Candidate ring_[PIPELINE_DEPTH];
+	int position_;
+};
+
+// Updates written as "+ u v t" / "- u v t" lines (GraphScheduler format)
+class StreamWriter {
+public:
+	explicit StreamWriter(FILE* out) : out_(out), buffer_(OUTPUT_BUFFER_SIZE + 64), used_(0) {
+	}
+	~StreamWriter() {
+		flush();
+	}
+
+	inline void write(bool is_add, int u, int v, unsigned long long time) {
+		char* p = buffer_.data() + used_;
+		*p++ = is_add ? '+' : '-';
+		*p++ = ' ';
+		p = put_number(p, u);
+		*p++ = ' ';
+		p = put_number(p, v);
+		*p++ = ' ';
+		p = put_number(p, time);
+		*p++ = '\n';
+		used_ = p - buffer_.data();
+		if (used_ >= OUTPUT_BUFFER_SIZE) {
+			flush();
+		}
+	}
+
+	void flush() {
+		if (used_ > 0 && fwrite(buffer_.data(), 1, used_, out_) != used_) {
+			cerr << "ERROR cannot write the stream" << endl;
+			exit(1);
+		}
+		used_ = 0;
+	}
+
+private:
+	static inline char* put_number(char* p, unsigned long long value) {
+		char digits[20];
+		int n = 0;
+		do {
+			digits[n++] = '0' + value % 10;
+			value /= 10;
+		} while (value > 0);
+		while (n > 0) {
+			*p++ = digits[--n];
+		}
+		return p;
+	}
+
+	FILE* out_;
+	vector<char> buffer_;
+	size_t used_;
+};
+
+int main(int argc, char** argv) {
+
+	// Named options, removed from the positional parameters
+	double gamma = 2.1;
+	int community_size = 50;
+	double intra = 0.9;
+	Deletions deletions = NO_DELETIONS;
+	double deletion_rate = 0;
+	unsigned long long batch = 0;
+	double batch_fraction = 0;
+	unsigned long long window = 0;
+	int num_positional = 1;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--gamma") == 0 && i+1 < argc) {
+			gamma = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--community-size") == 0 && i+1 < argc) {
+			community_size = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--intra") == 0 && i+1 < argc) {
+			intra = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--random-deletions") == 0 && i+1 < argc) {
+			deletions = RANDOM_DELETIONS;
+			deletion_rate = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--batch-deletions") == 0 && i+1 < argc) {
+			deletions = BATCH_DELETIONS;
+			batch = atoll(argv[++i]);
+			const char* fraction = strchr(argv[i], ',');
+			batch_fraction = fraction != NULL ? atof(fraction+1) : 0.5;
+		} else if (strcmp(argv[i], "--window") == 0 && i+1 < argc) {
+			deletions = WINDOW_DELETIONS;
+			window = atoll(argv[++i]);
+		} else {
+			argv[num_positional++] = argv[i];
+		}
+	}
+	argc = num_positional;
+
+	if (argc <= 4) {
+		cerr
+				<< "ERROR Requires 4 parameters. GenerateStream model (ER for Erdos-Renyi, CL for Chung-Lu power law, PC for planted communities); num_nodes (int); num_additions (int); random_seed (int)\n"
+				<< "Writes to stdout the updates \"+ u v t\" / \"- u v t\" (t = number of additions so far), each edge added only when not in the graph. The stream depends only on the parameters.\n"
+				<< "OPTIONS: --gamma g (CL degree exponent, default 2.1); --community-size c (PC, default 50); --intra p (PC, prob of an edge inside a community, default 0.9); "
+				<< "--random-deletions r (after each addition a random edge is deleted with prob r); --batch-deletions b[,f] (every b additions a fraction f of the edges, default 0.5, is deleted at once); "
+				<< "--window w (each edge is deleted w additions after its own, sliding window expiry)" << endl;
+		exit(1);
+	}
+
+	Model model;
+	if (strcmp(argv[1], "ER") == 0) {
+		model = ERDOS_RENYI;
+	} else if (strcmp(argv[1], "CL") == 0) {
+		model = CHUNG_LU;
+	} else if (strcmp(argv[1], "PC") == 0) {
+		model = COMMUNITIES;
+	} else {
+		cerr << argv[1] << " not supported." << endl;
+		exit(1);
+	}
+	long long num_nodes = atoll(argv[2]);
+	assert(num_nodes > 1 && num_nodes <= MAX_NUM_NODES);
+	unsigned long long num_additions = atoll(argv[3]);
+	mt19937_64 rng(atoll(argv[4]));
+	assert(gamma > 1 && community_size > 1 && intra >= 0 && intra <= 1);
+	assert(deletion_rate >= 0 && deletion_rate <= 1 && batch_fraction >= 0 && batch_fraction <= 1);
+
+	// Edges in the graph: in a set and in a vector (deque for the window
+	// expiry) to pick the ones to delete.
+	FlatEdgeSet present;
+	vector<pair<int,int>> edges;
+	deque<pair<int,int>> window_edges;
+	CandidateStream candidates(model, num_nodes, gamma, community_size, intra, &rng, &present);
+	StreamWriter out(stdout);
+
+	for (unsigned long long time = 1; time <= num_additions; time++) {
+		int u, v;
+		int attempts = 0;
+		do {
+			if (++attempts > MAX_ATTEMPTS) {
+				cerr << "ERROR cannot find an edge not in the graph, too many edges for the nodes." << endl;
+				exit(1);
+			}
+			pair<int,int> candidate = candidates.next();
+			u = candidate.first;
+			v = candidate.second;
+		} while (u == v || !present.insert(edge_to_id(u, v)));
+		out.write(true, u, v, time);
+
+		if (deletions == WINDOW_DELETIONS) {
+			window_edges.push_back(make_pair(u, v));
+			if (window_edges.size() > window) {
+				if (window_edges.size() > PIPELINE_DEPTH) {
+					const pair<int,int>& later = window_edges[PIPELINE_DEPTH];
+					present.prefetch(edge_to_id(later.first, later.second));
+				}
+				pair<int,int> expired = window_edges.front();
+				window_edges.pop_front();
+				present.erase(edge_to_id(expired.first, expired.second));
+				out.write(false, expired.first, expired.second, time);
+			}
+			continue;
+		}
+		if (deletions != NO_DELETIONS) {
+			edges.push_back(make_pair(u, v));
+		}
+		unsigned long long to_delete = 0;
+		if (deletions == RANDOM_DELETIONS) {
+			to_delete = uniform_01_64(rng) < deletion_rate ? 1 : 0;
+		} else if (deletions == BATCH_DELETIONS && batch > 0 && time % batch == 0) {
+			to_delete = (unsigned long long)(edges.size() * batch_fraction);
+		}
+		for (unsigned long long i = 0; i < to_delete && !edges.empty(); i++) {
+			size_t chosen = rng() % edges.size();
+			swap(edges[chosen], edges.back());
+			pair<int,int> deleted = edges.back();
+			edges.pop_back();
+			present.erase(edge_to_id(deleted.first, deleted.second));
+			out.write(false, deleted.first, deleted.second, time);
+		}
+	}
+	return 0;
+}
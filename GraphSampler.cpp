@@ -1,8 +1,12 @@
 #include "GraphSampler.h"
+#include "MemoryUsage.h"
 #include <random>
 #include <cassert>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+#include <sstream>
 #include <boost/math/distributions/hypergeometric.hpp>
 #include <boost/math/distributions/hypergeometric.hpp>
 #include <boost/math/policies/policy.hpp>
@@ -10,7 +14,9 @@
 
 using namespace std;
 
-GraphSampler::GraphSampler(TriangleCounter* counter) : counter_(counter) {
+// The generator is seeded from rand() so that srand() in the main still
+// determines all the random choices of the samplers.
+GraphSampler::GraphSampler(TriangleCounter* counter) : counter_(counter), rng_(rand()) {
 	if (counter_){
 		counter_->clear();
 	}
@@ -18,6 +24,46 @@ GraphSampler::GraphSampler(TriangleCounter* counter) : counter_(counter) {
 
 GraphSampler::~GraphSampler(){}
 
+bool GraphSampler::save(SnapshotWriter*) const{
+	return false;
+}
+
+bool GraphSampler::load(SnapshotReader*){
+	return false;
+}
+
+bool GraphSampler::summary(EdgeSummary*) const{
+	return false;
+}
+
+void GraphSampler::memory_usage(MemoryUsage* usage) const{
+	if (counter_){
+		counter_->memory_usage(usage);
+	}
+}
+
+void GraphSampler::save_rng(SnapshotWriter* out) const{
+	ostringstream state;
+	state << rng_;
+	out->put_string(state.str());
+}
+
+bool GraphSampler::load_rng(SnapshotReader* in){
+	string state;
+	if (!in->get_string(&state)){
+		return false;
+	}
+	istringstream state_stream(state);
+	state_stream >> rng_;
+	return !state_stream.fail();
+}
+
+void GraphSampler::exec_batch(const vector<EdgeUpdate>& updates){
+	for (const auto& update: updates){
+		exec_operation(update);
+	}
+}
+
 FixedPSampler::FixedPSampler(double p, bool use_sample_and_hold, TriangleCounter* counter)
 	: GraphSampler(counter), p_(p), use_sample_and_hold_(use_sample_and_hold){
 }
@@ -29,7 +75,7 @@ void FixedPSampler::exec_operation(const EdgeUpdate& update){
 	counter_->new_update(update);
 
 	if (update.is_add){
-		double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
+		double u_rand = rand_uniform();
 
 		if(use_sample_and_hold_){ // always count first
 			counter_->add_triangles(update.node_u, update.node_v, 1.0); //Weight not used
@@ -71,37 +117,200 @@ double FixedPSampler::get_triangle_est_local(int node){
 	}
 }
 
+bool FixedPSampler::save(SnapshotWriter* out) const{
+	out->put(p_);
+	out->put(use_sample_and_hold_);
+	save_rng(out);
+	counter_->save(out, true /* the sample is only in the counter */);
+	return true;
+}
+
+bool FixedPSampler::load(SnapshotReader* in){
+	return in->get(&p_) && in->get(&use_sample_and_hold_) && load_rng(in)
+			&& counter_->load(in, true);
+}
+
+// ****************************************
+// Exact
+
+ExactSampler::ExactSampler(bool local) : GraphSampler(NULL), local_(local), triangles_(0){
+}
+
+ExactSampler::~ExactSampler(){}
+
+void ExactSampler::add_node(int u){
+	if ((size_t)u >= seen_.size()){
+		size_t size = max((size_t)u + 1, 2 * seen_.size());
+		seen_.resize(size, false);
+		adjacency_.resize(size);
+		if (local_){
+			triangles_local_.resize(size, 0);
+		}
+	}
+	if (!seen_[u]){
+		seen_[u] = true;
+		nodes_.push_back(u);
+	}
+}
+
+void ExactSampler::update_triangles(int u, int v, int sign){
+	PROFILE_PHASE(PHASE_PROBE);
+	if (adjacency_[u].size() > adjacency_[v].size()){
+		swap(u, v);
+	}
+	PROFILE_COUNT(EVENT_NEIGHBORS_SCANNED, adjacency_[u].size());
+	PROFILE_COUNT(EVENT_EDGE_PROBES, adjacency_[u].size());
+	for (const auto& n: adjacency_[u]){
+		if (n != v && edges_.contains(edge_to_id(n, v))){
+			PROFILE_COUNT(EVENT_TRIANGLES_FOUND, 1);
+			triangles_ += sign;
+			if (local_){
+				triangles_local_[u] += sign;
+				triangles_local_[v] += sign;
+				triangles_local_[n] += sign;
+			}
+		}
+	}
+}
+
+void ExactSampler::exec_operation(const EdgeUpdate& update){
+	int u = update.node_u;
+	int v = update.node_v;
+	if (update.is_add){
+		add_node(u);
+		add_node(v);
+		if (edges_.insert(edge_to_id(u, v))){
+			update_triangles(u, v, 1);
+			adjacency_[u].push_back(v);
+			adjacency_[v].push_back(u);
+		}
+	} else if (edges_.erase(edge_to_id(u, v))){
+		for (int node: {u, v}){
+			vector<int>& neighbors = adjacency_[node];
+			*find(neighbors.begin(), neighbors.end(), node == u ? v : u) = neighbors.back();
+			neighbors.pop_back();
+		}
+		update_triangles(u, v, -1);
+	}
+}
+
+double ExactSampler::get_triangle_est(){
+	return triangles_;
+}
+
+double ExactSampler::get_triangle_est_local(int node){
+	assert(local_);
+	return (size_t)node < triangles_local_.size() ? triangles_local_[node] : 0;
+}
+
+void ExactSampler::memory_usage(MemoryUsage* usage) const{
+	size_t graph_bytes = vector_bytes(adjacency_) + vector_bytes(seen_) + vector_bytes(nodes_);
+	for (const auto& neighbors: adjacency_){
+		graph_bytes += vector_bytes(neighbors);
+	}
+	usage->bytes[MEMORY_GRAPH] += graph_bytes;
+	usage->bytes[MEMORY_EDGE_INDEX] += edges_.memory_bytes();
+	usage->bytes[MEMORY_LOCAL_COUNTS] += vector_bytes(triangles_local_);
+}
+
 //RESERVOIR SAMPLER
 
 ReservoirSampler::ReservoirSampler(size_t reservoir_size, bool use_sample_and_hold, TriangleCounter* counter)
-	: GraphSampler(counter), reservoir_size_(reservoir_size), use_sample_and_hold_(use_sample_and_hold){
+	: GraphSampler(counter), reservoir_size_(reservoir_size), use_sample_and_hold_(use_sample_and_hold), memory_budget_(0){
 		reservoir_.reserve(reservoir_size);
 }
 
 ReservoirSampler::~ReservoirSampler(){}
 
+void ReservoirSampler::set_memory_budget(size_t bytes){
+	assert(reservoir_.empty());
+	memory_budget_ = bytes;
+	reservoir_size_ = numeric_limits<unsigned long long>::max(); // until the budget is reached
+	vector<pair<int,int>>().swap(reservoir_);
+}
+
+size_t ReservoirSampler::memory_bytes() const{
+	MemoryUsage usage;
+	memory_usage(&usage);
+	return usage.total() - usage.bytes[MEMORY_LOCAL_COUNTS];
+}
+
+void ReservoirSampler::memory_usage(MemoryUsage* usage) const{
+	usage->bytes[MEMORY_RESERVOIR] += vector_bytes(reservoir_);
+	counter_->memory_usage(usage);
+}
+
+// Evicts random edges until the sample fits in the budget and makes the
+// reservoir size the one reached. A uniform subsample of a uniform sample is
+// uniform, so the estimators stay valid with the new reservoir size. While
+// the sample holds all the edges of the stream it is a uniform sample for
+// any larger size too, so the reservoir grows again up to the budget.
+void ReservoirSampler::fit_memory_budget(){
+	if (memory_bytes() <= memory_budget_){
+		if (reservoir_.size() == counter_->edges_present_original()){
+			reservoir_size_ = numeric_limits<unsigned long long>::max();
+		}
+		return;
+	}
+	while (reservoir_.size() > 3 && memory_bytes() > memory_budget_){
+		PROFILE_COUNT(EVENT_EVICTIONS, 1);
+		delete_reservoir(reservoir_[rand_int(reservoir_.size())]);
+	}
+	reservoir_size_ = reservoir_.size();
+}
+
+
+bool ReservoirSampler::save(SnapshotWriter* out) const{
+	out->put(use_sample_and_hold_);
+	out->put(memory_budget_);
+	out->put(reservoir_size_);
+	out->put_vector(reservoir_);
+	save_rng(out);
+	counter_->save(out, false /* same edges of the reservoir */);
+	return true;
+}
+
+bool ReservoirSampler::load(SnapshotReader* in){
+	if (!in->get(&use_sample_and_hold_) || !in->get(&memory_budget_)
+			|| !in->get(&reservoir_size_) || !in->get_vector(&reservoir_)
+			|| !load_rng(in) || !counter_->load(in, false)){
+		return false;
+	}
+	for (size_t i = 0; i < reservoir_.size(); i++){
+		counter_->add_edge_sample(reservoir_[i].first, reservoir_[i].second, i);
+	}
+	return true;
+}
+
+bool ReservoirSampler::summary(EdgeSummary* out) const{
+	out->kind = EdgeSummary::UNIFORM;
+	out->size = reservoir_size_;
+	out->edges = counter_->edges_present_original();
+	out->hash_seed = 0;
+	out->threshold = 1.0;
+	out->sample = reservoir_;
+	return true;
+}
 
 void ReservoirSampler::add_reservoir(const pair<int,int> edge){
 	//cout<<"ADD RES"<<edge.first<<" "<<edge.second<<endl;
-	assert(reservoir_map_.find(edge) == reservoir_map_.end());
+	assert(counter_->edge_slot(edge.first, edge.second) < 0);
 	reservoir_.push_back(edge);
-	reservoir_map_.insert(make_pair(edge, reservoir_.size()-1));
-	counter_->add_edge_sample(edge.first, edge.second);
+	counter_->add_edge_sample(edge.first, edge.second, reservoir_.size()-1);
 	if (!use_sample_and_hold_){
 		counter_->add_triangles(edge.first, edge.second, 1.0); //Weight not used
 	}
 }
 
 void ReservoirSampler::delete_reservoir(const pair<int,int> edge){
-	if (reservoir_map_.find(edge) == reservoir_map_.end()){
+	int pos = counter_->edge_slot(edge.first, edge.second);
+	if (pos < 0){
 		return;
 	}
-	int pos = reservoir_map_.at(edge);
-	reservoir_map_.erase(edge);
 	if (pos < reservoir_.size() -1){ // not the last item
 		pair<int, int> last_edge = reservoir_.back();
 		reservoir_[pos] = last_edge;
-		reservoir_map_[last_edge] = pos;
+		counter_->set_edge_slot(last_edge.first, last_edge.second, pos);
 	}
 	reservoir_.pop_back();
 	bool succ = counter_->remove_edge_sample(edge.first, edge.second);
@@ -111,7 +320,7 @@ void ReservoirSampler::delete_reservoir(const pair<int,int> edge){
 
 	assert(succ);
 	assert(reservoir_.size()<=reservoir_size_);
-	assert(reservoir_.size()==reservoir_map_.size());
+	assert(reservoir_.size()==(size_t)counter_->size_sample());
 }
 
 void ReservoirSampler::exec_operation(const EdgeUpdate& update){
@@ -125,7 +334,7 @@ void ReservoirSampler::exec_operation(const EdgeUpdate& update){
 	counter_->new_update(update);
 
 	//if(update.is_add){
-	assert(reservoir_map_.find(edge) == reservoir_map_.end());
+	assert(counter_->edge_slot(edge.first, edge.second) < 0);
 
 	// Prob of sampling at this step if using sample and hold
   double p = 0;
@@ -146,11 +355,12 @@ void ReservoirSampler::exec_operation(const EdgeUpdate& update){
 	if (reservoir_.size() < reservoir_size_){
 		add_reservoir(edge);
 	} else {
-		double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
+		double u_rand = rand_uniform();
 		double thres = ((double)reservoir_size_)/counter_->edges_present_original();
 		if (u_rand < thres){
+			PROFILE_COUNT(EVENT_EVICTIONS, 1);
 			// Doing the exchange
-			int rand_pos = rand()%reservoir_size_;
+			int rand_pos = rand_int(reservoir_size_);
 			const pair<int,int>& to_remove = reservoir_[rand_pos];
 			delete_reservoir(to_remove);
 			add_reservoir(edge);
@@ -159,6 +369,10 @@ void ReservoirSampler::exec_operation(const EdgeUpdate& update){
 	//} else { // is remove
 	//	delete_reservoir(edge);
 	//}
+
+	if (memory_budget_ > 0){
+		fit_memory_budget();
+	}
 }
 
  double ReservoirSampler::get_triangle_est(){
@@ -204,47 +418,196 @@ void ReservoirSampler::exec_operation(const EdgeUpdate& update){
 }
 
 
+// ****************************************
+// Coordinated (bottom-k) reservoir
+
+CoordinatedSampler::CoordinatedSampler(size_t reservoir_size, unsigned long long hash_seed, TriangleCounter* counter)
+	: GraphSampler(counter), reservoir_size_(reservoir_size), hash_seed_(hash_seed), threshold_(1.0){
+	reservoir_.reserve(reservoir_size);
+}
+
+CoordinatedSampler::~CoordinatedSampler(){}
+
+void CoordinatedSampler::exec_operation(const EdgeUpdate& update){
+	assert(update.is_add); //only add supported
+	assert(update.node_u != update.node_v);
+	pair<int,int> edge = make_pair(min(update.node_u, update.node_v), max(update.node_u, update.node_v));
+
+	counter_->new_update(update);
+
+	double hash = edge_hash_01(edge.first, edge.second, hash_seed_);
+	if (reservoir_.size() == reservoir_size_){
+		if (hash >= reservoir_.front().first){
+			threshold_ = min(threshold_, hash);
+			return;
+		}
+		// The edge with the largest hash leaves the sample
+		PROFILE_COUNT(EVENT_EVICTIONS, 1);
+		pop_heap(reservoir_.begin(), reservoir_.end());
+		const pair<int,int>& to_remove = reservoir_.back().second;
+		bool succ = counter_->remove_edge_sample(to_remove.first, to_remove.second);
+		assert(succ);
+		counter_->remove_triangles(to_remove.first, to_remove.second, 1.0); //Weight not used
+		threshold_ = reservoir_.back().first;
+		reservoir_.pop_back();
+	}
+	counter_->add_triangles(edge.first, edge.second, 1.0); //Weight not used
+	bool succ = counter_->add_edge_sample(edge.first, edge.second);
+	assert(succ); // edge updates need to be distinct
+	reservoir_.push_back(make_pair(hash, edge));
+	push_heap(reservoir_.begin(), reservoir_.end());
+}
+
+double CoordinatedSampler::get_triangle_est(){
+	return counter_->triangles()/(threshold_*threshold_*threshold_);
+}
+
+double CoordinatedSampler::get_triangle_est_local(int node){
+	assert(counter_->is_local());
+	return counter_->triangles_local(node)/(threshold_*threshold_*threshold_);
+}
+
+bool CoordinatedSampler::save(SnapshotWriter* out) const{
+	out->put(reservoir_size_);
+	out->put(hash_seed_);
+	out->put(threshold_);
+	out->put_vector(reservoir_);
+	counter_->save(out, false /* same edges of the reservoir */);
+	return true;
+}
+
+bool CoordinatedSampler::load(SnapshotReader* in){
+	if (!in->get(&reservoir_size_) || !in->get(&hash_seed_) || !in->get(&threshold_)
+			|| !in->get_vector(&reservoir_) || !counter_->load(in, false)){
+		return false;
+	}
+	for (const auto& hashed_edge: reservoir_){
+		counter_->add_edge_sample(hashed_edge.second.first, hashed_edge.second.second);
+	}
+	return true;
+}
+
+bool CoordinatedSampler::summary(EdgeSummary* out) const{
+	out->kind = EdgeSummary::COORDINATED;
+	out->size = reservoir_size_;
+	out->edges = counter_->edges_present_original();
+	out->hash_seed = hash_seed_;
+	out->threshold = threshold_;
+	out->sample.clear();
+	for (const auto& hashed_edge: reservoir_){
+		out->sample.push_back(hashed_edge.second);
+	}
+	return true;
+}
+
+void CoordinatedSampler::memory_usage(MemoryUsage* usage) const{
+	usage->bytes[MEMORY_RESERVOIR] += vector_bytes(reservoir_);
+	counter_->memory_usage(usage);
+}
+
 // ****************************************
 // Reservoir add & remove
 
 
 
 ReservoirAddRemSampler::ReservoirAddRemSampler(size_t reservoir_size, TriangleCounter* counter)
-	: GraphSampler(counter), reservoir_size_(reservoir_size), d_i_(0), d_o_(0){
+	: GraphSampler(counter), memory_budget_(0), prob_cache_valid_(false), d_i_(0), d_o_(0), reservoir_size_(reservoir_size){
 		reservoir_.reserve(reservoir_size);
 }
 
 ReservoirAddRemSampler::~ReservoirAddRemSampler(){}
 
+void ReservoirAddRemSampler::set_memory_budget(size_t bytes){
+	assert(reservoir_.empty());
+	memory_budget_ = bytes;
+	reservoir_size_ = numeric_limits<unsigned long long>::max(); // until the budget is reached
+	vector<pair<int,int>>().swap(reservoir_);
+}
+
+size_t ReservoirAddRemSampler::memory_bytes() const{
+	MemoryUsage usage;
+	memory_usage(&usage);
+	return usage.total() - usage.bytes[MEMORY_LOCAL_COUNTS];
+}
+
+void ReservoirAddRemSampler::memory_usage(MemoryUsage* usage) const{
+	usage->bytes[MEMORY_RESERVOIR] += vector_bytes(reservoir_);
+	counter_->memory_usage(usage);
+}
+
+// As in ReservoirSampler. Only done when d_i + d_o = 0, when the reservoir is
+// a uniform sample of min(M, s) edges; otherwise postponed (the reservoir
+// does not grow until the deletions are compensated). When the sample holds
+// all the edges of the graph (e.g. after massive deletions) the pending
+// deletions are void and the reservoir grows again up to the budget.
+void ReservoirAddRemSampler::fit_memory_budget(){
+	if (reservoir_.size() == counter_->edges_present_original() && memory_bytes() <= memory_budget_){
+		d_i_ = d_o_ = 0;
+		reservoir_size_ = numeric_limits<unsigned long long>::max();
+		prob_cache_valid_ = false;
+		return;
+	}
+	if (d_i_ + d_o_ > 0 || memory_bytes() <= memory_budget_){
+		return;
+	}
+	while (reservoir_.size() > 3 && memory_bytes() > memory_budget_){
+		PROFILE_COUNT(EVENT_EVICTIONS, 1);
+		delete_reservoir(reservoir_[rand_int(reservoir_.size())]);
+	}
+	reservoir_size_ = reservoir_.size();
+	prob_cache_valid_ = false;
+}
+
+
+bool ReservoirAddRemSampler::save(SnapshotWriter* out) const{
+	out->put(memory_budget_);
+	out->put(d_i_);
+	out->put(d_o_);
+	out->put(reservoir_size_);
+	out->put_vector(reservoir_);
+	save_rng(out);
+	counter_->save(out, false /* same edges of the reservoir */);
+	return true;
+}
+
+bool ReservoirAddRemSampler::load(SnapshotReader* in){
+	prob_cache_valid_ = false;
+	if (!in->get(&memory_budget_) || !in->get(&d_i_) || !in->get(&d_o_)
+			|| !in->get(&reservoir_size_) || !in->get_vector(&reservoir_)
+			|| !load_rng(in) || !counter_->load(in, false)){
+		return false;
+	}
+	for (size_t i = 0; i < reservoir_.size(); i++){
+		counter_->add_edge_sample(reservoir_[i].first, reservoir_[i].second, i);
+	}
+	return true;
+}
 
 void ReservoirAddRemSampler::add_reservoir(const pair<int,int> edge){
 	//cout<<"ADD RES"<<edge.first<<" "<<edge.second<<endl;
   int before_size = reservoir_.size();
 
-	assert(reservoir_map_.find(edge) == reservoir_map_.end());
+	assert(counter_->edge_slot(edge.first, edge.second) < 0);
 	reservoir_.push_back(edge);
-	reservoir_map_.insert(make_pair(edge, reservoir_.size()-1));
-	bool succ = counter_->add_edge_sample(edge.first, edge.second);
+	bool succ = counter_->add_edge_sample(edge.first, edge.second, reservoir_.size()-1);
 
   assert (succ);
   assert(reservoir_.size()<=reservoir_size_);
-  assert(reservoir_.size()==reservoir_map_.size());
-  assert (reservoir_map_.find(edge) != reservoir_map_.end());
+  assert(reservoir_.size()==(size_t)counter_->size_sample());
   assert(reservoir_.size()== before_size +1);
 }
 
 void ReservoirAddRemSampler::delete_reservoir(const pair<int,int> edge){
   //cout<<"REM RES"<<edge.first<<" "<<edge.second<<endl;
 
-  assert (reservoir_map_.find(edge) != reservoir_map_.end());
   int before_size = reservoir_.size();
 
-	int pos = reservoir_map_.at(edge);
-	reservoir_map_.erase(edge);
+	int pos = counter_->edge_slot(edge.first, edge.second);
+	assert(pos >= 0);
 	if (pos < reservoir_.size() -1){ // not the last item
 		pair<int, int> last_edge = reservoir_.back();
 		reservoir_[pos] = last_edge;
-		reservoir_map_[last_edge] = pos;
+		counter_->set_edge_slot(last_edge.first, last_edge.second, pos);
 	}
 	reservoir_.pop_back();
 	bool succ = counter_->remove_edge_sample(edge.first, edge.second);
@@ -252,8 +615,7 @@ void ReservoirAddRemSampler::delete_reservoir(const pair<int,int> edge){
 
 	assert(succ);
 	assert(reservoir_.size()<=reservoir_size_);
-	assert(reservoir_.size()==reservoir_map_.size());
-  assert (reservoir_map_.find(edge) == reservoir_map_.end());
+	assert(reservoir_.size()==(size_t)counter_->size_sample());
   assert(reservoir_.size()== before_size -1);
 }
 
@@ -267,10 +629,10 @@ void ReservoirAddRemSampler::exec_operation(const EdgeUpdate& update){
 	counter_->new_update(update);
 
 	if(update.is_add){
-		assert(reservoir_map_.find(edge) == reservoir_map_.end());
+		assert(counter_->edge_slot(edge.first, edge.second) < 0);
 
     if (d_o_ + d_i_ > 0) { // case d_o + d_i > 0
-      double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
+      double u_rand = rand_uniform();
 			double thres = ((double)d_i_)/(d_i_+d_o_);
       if (u_rand < thres){ //with pro d_i / (d_i + d_o)
         d_i_ --;
@@ -289,11 +651,12 @@ void ReservoirAddRemSampler::exec_operation(const EdgeUpdate& update){
 		} else { // reservoid full and d_i + d_o = 0
       assert (counter_->edges_present_original()>reservoir_size_);
 
-			double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
+			double u_rand = rand_uniform();
 			double thres = ((double)reservoir_size_)/(counter_->edges_present_original());
 			if (u_rand < thres){
+				PROFILE_COUNT(EVENT_EVICTIONS, 1);
 				// Doing the exchange
-				int rand_pos = rand()%reservoir_size_;
+				int rand_pos = rand_int(reservoir_size_);
 				pair<int,int> to_remove = reservoir_[rand_pos];
 
         size_t before_size = reservoir_.size();
@@ -302,19 +665,23 @@ void ReservoirAddRemSampler::exec_operation(const EdgeUpdate& update){
 				add_reservoir(edge);
 
         assert(reservoir_.size()<=reservoir_size_);
-        assert(reservoir_.size()==reservoir_map_.size());
-        assert (reservoir_map_.find(to_remove) == reservoir_map_.end());
-        assert (reservoir_map_.find(edge) != reservoir_map_.end());
+        assert(reservoir_.size()==(size_t)counter_->size_sample());
+        assert(counter_->edge_slot(to_remove.first, to_remove.second) < 0);
+        assert(counter_->edge_slot(edge.first, edge.second) >= 0);
         assert(reservoir_.size()== before_size);
 
 
 				counter_->add_triangles(edge.first, edge.second, 1.0); //Weight not used
 			}
 		}
+
+		if (memory_budget_ > 0){
+			fit_memory_budget();
+		}
 	} else { // is remove
     assert(counter_->edges_present_original()>=0);
 
-		if (reservoir_map_.find(edge) != reservoir_map_.end()){//Was present
+		if (counter_->edge_slot(edge.first, edge.second) >= 0){//Was present
       d_i_ ++; // deletion in sample
 
 			delete_reservoir(edge);
@@ -330,6 +697,14 @@ double ReservoirAddRemSampler::prob_sampling_triangle() const{
     return 0;
   }
   unsigned long long int s = counter_->edges_present_original();
+  unsigned long long int d = d_i_+d_o_;
+
+  // The probability only depends on (s, |reservoir|, d_i + d_o), reuse it
+  // between updates that do not change them and across local queries.
+  if (prob_cache_valid_ && prob_cache_s_ == s && prob_cache_d_ == d
+      && prob_cache_m_ == reservoir_.size()) {
+    return prob_cache_;
+  }
 
   //cout<<"SIZES: "<<reservoir_.size()<< " " <<s<<endl;
   assert ((unsigned long long int)reservoir_.size()<=s);
@@ -346,24 +721,36 @@ double ReservoirAddRemSampler::prob_sampling_triangle() const{
 
   assert (p<=1);
 
-  unsigned long long int n = min((unsigned long long int)reservoir_size_, s+d_i_+d_o_);
+  unsigned long long int n = min((unsigned long long int)reservoir_size_, s+d);
 
-  boost::math::hypergeometric_distribution<double> hyper(s, n, d_i_+d_o_+s);
+  // Sum of the pdf for i = 0..2 in the support [n - d, min(n, s)] (nothing
+  // when n < d). Outside of the narrow band n - d <= 2 the sum is empty and
+  // the distribution is not evaluated.
   double kt = 0;
-
-  for (int i = 0; i<=2 ; i++){
-    if (i >= max(0ull, (unsigned long long int)(n) +  - d_i_-d_o_) && i <= min((unsigned long long int)(n), s)){
-      kt += boost::math::pdf<double>(hyper, i);
+  if (n >= d && n - d <= 2) {
+    boost::math::hypergeometric_distribution<double> hyper(s, n, d+s);
+    for (unsigned long long int i = n - d; i<=2 ; i++){
+      if (i <= min(n, s)){
+        kt += boost::math::pdf<double>(hyper, i);
+      }
     }
   }
 
-  return p*(1-kt);
+  prob_cache_valid_ = true;
+  prob_cache_s_ = s;
+  prob_cache_d_ = d;
+  prob_cache_m_ = reservoir_.size();
+  prob_cache_ = p*(1-kt);
+  return prob_cache_;
 }
 
 
 double ReservoirAddRemSampler::get_triangle_est(){
 
   double prob = prob_sampling_triangle();
+  if (prob == 0) {
+    return 0; // no triangles possible
+  }
 	return counter_->triangles() / prob;
 }
 
@@ -371,14 +758,339 @@ double ReservoirAddRemSampler::get_triangle_est_local(int node){
 	assert(counter_->is_local());
 
   double prob = prob_sampling_triangle();
+  if (prob == 0) {
+    return 0; // no triangles possible
+  }
 	return counter_->triangles_local(node) / prob;
 }
 
 
+// ****************************************
+// ThinkD
+
+ThinkDSampler::ThinkDSampler(size_t reservoir_size, TriangleCounter* counter)
+	: GraphSampler(counter), d_i_(0), d_o_(0), reservoir_size_(reservoir_size), sample_triangles_(0){
+	reservoir_.reserve(reservoir_size);
+}
+
+ThinkDSampler::~ThinkDSampler(){}
+
+bool ThinkDSampler::save(SnapshotWriter* out) const{
+	out->put(d_i_);
+	out->put(d_o_);
+	out->put(reservoir_size_);
+	out->put_vector(reservoir_);
+	save_rng(out);
+	counter_->save(out, false /* same edges of the reservoir */);
+	return true;
+}
+
+bool ThinkDSampler::load(SnapshotReader* in){
+	if (!in->get(&d_i_) || !in->get(&d_o_) || !in->get(&reservoir_size_)
+			|| !in->get_vector(&reservoir_) || !load_rng(in) || !counter_->load(in, false)){
+		return false;
+	}
+	for (size_t i = 0; i < reservoir_.size(); i++){
+		counter_->add_edge_sample(reservoir_[i].first, reservoir_[i].second, i);
+	}
+	// Each triangle of the sample is found from its 3 edges
+	sample_triangles_ = 0;
+	for (const auto& edge: reservoir_){
+		sample_triangles_ += counter_->common_neighbors(edge.first, edge.second);
+	}
+	sample_triangles_ /= 3;
+	return true;
+}
+
+void ThinkDSampler::memory_usage(MemoryUsage* usage) const{
+	usage->bytes[MEMORY_RESERVOIR] += vector_bytes(reservoir_);
+	counter_->memory_usage(usage);
+}
+
+void ThinkDSampler::add_reservoir(const pair<int,int> edge){
+	assert(counter_->edge_slot(edge.first, edge.second) < 0);
+	reservoir_.push_back(edge);
+	bool succ = counter_->add_edge_sample(edge.first, edge.second, reservoir_.size()-1);
+
+	assert(succ);
+	assert(reservoir_.size()<=reservoir_size_);
+}
+
+void ThinkDSampler::delete_reservoir(const pair<int,int> edge){
+	int pos = counter_->edge_slot(edge.first, edge.second);
+	assert(pos >= 0);
+	if ((size_t)pos < reservoir_.size() -1){ // not the last item
+		pair<int, int> last_edge = reservoir_.back();
+		reservoir_[pos] = last_edge;
+		counter_->set_edge_slot(last_edge.first, last_edge.second, pos);
+	}
+	reservoir_.pop_back();
+	bool succ = counter_->remove_edge_sample(edge.first, edge.second);
+
+	assert(succ);
+	assert(reservoir_.size()==(size_t)counter_->size_sample());
+}
+
+double ThinkDSampler::prob_sampling_wedge() const{
+	// |E| + d_i + d_o edges of which min(M, |E| + d_i + d_o) sampled uniformly
+	double n = (double)counter_->edges_present_original() + d_i_ + d_o_;
+	double y = min((double)reservoir_size_, n);
+	if (y < 2){
+		return 0;
+	}
+	return (y/n)*((y-1)/(n-1));
+}
+
+void ThinkDSampler::exec_operation(const EdgeUpdate& update){
+	assert(update.node_u != update.node_v);
+	int max_n = (int)max(update.node_u, update.node_v);
+	int min_n = (int)min(update.node_u, update.node_v);
+
+	pair<int,int> edge = make_pair(min_n, max_n);
+
+	// Count before the sampling decision (on the graph before the update).
+	// With p = 0 the sample has less than 2 edges and no triangle.
+	double p = prob_sampling_wedge();
+	unsigned long long found = 0; // triangles of the edge with the sample
+	if (p > 0){
+		if (update.is_add){
+			unsigned long long before = counter_->triangles();
+			counter_->add_triangles(edge.first, edge.second, 1.0/p);
+			found = counter_->triangles() - before;
+		} else {
+			found = counter_->remove_triangles_weight(edge.first, edge.second, 1.0/p);
+		}
+	}
+
+	counter_->new_update(update);
+
+	// Random pairing
+	if (update.is_add){
+		assert(counter_->edge_slot(edge.first, edge.second) < 0);
+		if (d_i_ + d_o_ > 0){
+			if (rand_uniform() < ((double)d_i_)/(d_i_+d_o_)){
+				d_i_--;
+				add_reservoir(edge);
+				sample_triangles_ += found;
+			} else {
+				d_o_--;
+			}
+		} else if (reservoir_.size() < reservoir_size_){
+			add_reservoir(edge);
+			sample_triangles_ += found;
+		} else if (rand_uniform() < ((double)reservoir_size_)/counter_->edges_present_original()){
+			PROFILE_COUNT(EVENT_EVICTIONS, 1);
+			// found may include a triangle with the evicted edge
+			pair<int,int> evicted = reservoir_[rand_int(reservoir_size_)];
+			sample_triangles_ -= counter_->common_neighbors(evicted.first, evicted.second);
+			delete_reservoir(evicted);
+			sample_triangles_ += counter_->common_neighbors(edge.first, edge.second);
+			add_reservoir(edge);
+		}
+	} else {
+		if (counter_->edge_slot(edge.first, edge.second) >= 0){
+			d_i_++;
+			delete_reservoir(edge);
+			sample_triangles_ -= found;
+		} else {
+			d_o_++;
+		}
+	}
+}
+
+double ThinkDSampler::get_triangle_est(){
+	return counter_->triangles_weight();
+}
+
+double ThinkDSampler::get_triangle_est_local(int node){
+	assert(counter_->is_local());
+	return counter_->triangles_weight_local(node);
+}
+
+// ****************************************
+// Waiting room
+
+WaitingRoomSampler::WaitingRoomSampler(size_t memory_size, double waiting_room_fraction, TriangleCounter* counter)
+	: GraphSampler(counter), popped_(0){
+	assert(waiting_room_fraction >= 0 && waiting_room_fraction < 1);
+	waiting_room_size_ = (unsigned long long)(memory_size*waiting_room_fraction);
+	reservoir_size_ = memory_size - waiting_room_size_;
+	assert(reservoir_size_ >= 2);
+	reservoir_.reserve(reservoir_size_);
+}
+
+WaitingRoomSampler::~WaitingRoomSampler(){}
+
+double WaitingRoomSampler::prob_sampling_wedge(int u, int v, int n) const{
+	pair<int,int> e1 = make_pair(min(u,n), max(u,n));
+	pair<int,int> e2 = make_pair(min(v,n), max(v,n));
+	// The edges in the waiting room have no slot
+	int in_reservoir = (counter_->edge_slot(e1.first, e1.second) >= 0 ? 1 : 0)
+			+ (counter_->edge_slot(e2.first, e2.second) >= 0 ? 1 : 0);
+
+	// The edges in the waiting room are there with prob 1
+	double p = 1.0;
+	if (in_reservoir >= 1){
+		p *= min(1.0, (double)reservoir_size_/popped_);
+	}
+	if (in_reservoir == 2){
+		p *= min(1.0, (double)(reservoir_size_-1)/(popped_-1));
+	}
+	return p;
+}
+
+void WaitingRoomSampler::exec_operation(const EdgeUpdate& update){
+	assert(update.is_add); //only add supported
+	assert(update.node_u != update.node_v);
+	int max_n = (int)max(update.node_u, update.node_v);
+	int min_n = (int)min(update.node_u, update.node_v);
+
+	pair<int,int> edge = make_pair(min_n, max_n);
+
+	counter_->new_update(update);
+
+	counter_->add_triangles(min_n, max_n, [this, min_n, max_n](int n) {
+		return 1.0/prob_sampling_wedge(min_n, max_n, n);
+	});
+
+	waiting_room_.push_back(edge);
+	counter_->add_edge_sample(edge.first, edge.second);
+	if (waiting_room_.size() <= waiting_room_size_){
+		return;
+	}
+
+	// The oldest edge moves from the waiting room to the reservoir
+	pair<int,int> popped = waiting_room_.front();
+	waiting_room_.pop_front();
+	popped_++;
+
+	if (reservoir_.size() < reservoir_size_){
+		reservoir_.push_back(popped);
+		counter_->set_edge_slot(popped.first, popped.second, reservoir_.size()-1);
+	} else if (rand_uniform() < ((double)reservoir_size_)/popped_){
+		int rand_pos = rand_int(reservoir_size_);
+		pair<int,int> to_remove = reservoir_[rand_pos];
+		PROFILE_COUNT(EVENT_EVICTIONS, 1);
+		counter_->remove_edge_sample(to_remove.first, to_remove.second);
+		reservoir_[rand_pos] = popped;
+		counter_->set_edge_slot(popped.first, popped.second, rand_pos);
+	} else {
+		counter_->remove_edge_sample(popped.first, popped.second);
+	}
+}
+
+double WaitingRoomSampler::get_triangle_est(){
+	return counter_->triangles_weight();
+}
+
+double WaitingRoomSampler::get_triangle_est_local(int node){
+	assert(counter_->is_local());
+	return counter_->triangles_weight_local(node);
+}
+
+void WaitingRoomSampler::memory_usage(MemoryUsage* usage) const{
+	usage->bytes[MEMORY_RESERVOIR] += deque_bytes(waiting_room_) + vector_bytes(reservoir_);
+	counter_->memory_usage(usage);
+}
+
+// ****************************************
+// Sliding window
+
+SlidingWindowSampler::SlidingWindowSampler(size_t reservoir_size, int window_length, TriangleCounter* counter)
+	: ReservoirAddRemSampler(reservoir_size, counter), window_length_(window_length){
+	assert(window_length > 0);
+}
+
+SlidingWindowSampler::~SlidingWindowSampler(){}
+
+bool SlidingWindowSampler::save(SnapshotWriter* out) const{
+	out->put(window_length_);
+	out->put_vector(vector<pair<int, unsigned long long>>(arrivals_.begin(), arrivals_.end()));
+	out->put_vector(vector<pair<int, pair<int,int>>>(sampled_.begin(), sampled_.end()));
+	return ReservoirAddRemSampler::save(out);
+}
+
+bool SlidingWindowSampler::load(SnapshotReader* in){
+	vector<pair<int, unsigned long long>> arrivals;
+	vector<pair<int, pair<int,int>>> sampled;
+	if (!in->get(&window_length_) || !in->get_vector(&arrivals) || !in->get_vector(&sampled)){
+		return false;
+	}
+	arrivals_.assign(arrivals.begin(), arrivals.end());
+	sampled_.assign(sampled.begin(), sampled.end());
+	return ReservoirAddRemSampler::load(in);
+}
+
+void SlidingWindowSampler::memory_usage(MemoryUsage* usage) const{
+	usage->bytes[MEMORY_RESERVOIR] += deque_bytes(arrivals_) + deque_bytes(sampled_);
+	ReservoirAddRemSampler::memory_usage(usage);
+}
+
+void SlidingWindowSampler::expire(int now){
+	EdgeUpdate expired;
+	expired.is_add = false;
+	expired.time = now;
+
+	while (!arrivals_.empty() && arrivals_.front().first <= now - window_length_){
+		int time = arrivals_.front().first;
+		unsigned long long to_expire = arrivals_.front().second;
+		arrivals_.pop_front();
+
+		// The ones still in the reservoir
+		while (!sampled_.empty() && sampled_.front().first <= time){
+			const pair<int,int>& edge = sampled_.front().second;
+			if (counter_->edge_slot(edge.first, edge.second) >= 0){
+				expired.node_u = edge.first;
+				expired.node_v = edge.second;
+				ReservoirAddRemSampler::exec_operation(expired);
+				to_expire--;
+			}
+			sampled_.pop_front();
+		}
+
+		// The others are deletions out of the sample (only counted)
+		for (; to_expire > 0; to_expire--){
+			counter_->new_update(expired);
+			d_o_++;
+		}
+	}
+}
+
+void SlidingWindowSampler::exec_operation(const EdgeUpdate& update){
+	assert(update.is_add); //only add supported, deletions are the expirations
+	assert(arrivals_.empty() || arrivals_.back().first <= update.time);
+
+	expire(update.time);
+
+	ReservoirAddRemSampler::exec_operation(update);
+
+	if (arrivals_.empty() || arrivals_.back().first != update.time){
+		arrivals_.push_back(make_pair(update.time, 0ull));
+	}
+	arrivals_.back().second++;
+
+	pair<int,int> edge = make_pair(min(update.node_u, update.node_v), max(update.node_u, update.node_v));
+	if (counter_->edge_slot(edge.first, edge.second) >= 0){
+		sampled_.push_back(make_pair(update.time, edge));
+	}
+
+	// Drops the entries of the edges evicted from the reservoir (skipped by
+	// expire anyway) once they can be half of sampled_, so that sampled_
+	// stays within twice the reservoir size.
+	if (sampled_.size() > 2 * reservoir_size_){
+		TriangleCounter* counter = counter_;
+		sampled_.erase(remove_if(sampled_.begin(), sampled_.end(),
+				[counter](const pair<int, pair<int,int>>& entry) {
+			return counter->edge_slot(entry.second.first, entry.second.second) < 0;
+		}), sampled_.end());
+	}
+}
+
+
 // ALI PINAR Paper
 
 PinarSampler::PinarSampler(size_t edge_res_size, size_t wedge_res_size)
-	: GraphSampler(NULL/* no need of TriangleCounter*/), t_(0), tot_wedges_(0), fraction_closed_(0.0), edge_res_size_(edge_res_size), wedge_res_size_(wedge_res_size){
+	: GraphSampler(NULL/* no need of TriangleCounter*/), t_(0), tot_wedges_(0), closed_(0), fraction_closed_(0.0), edge_res_size_(edge_res_size), wedge_res_size_(wedge_res_size){
 		edge_reservoir_.resize(edge_res_size);
 		wedge_reservoir_.resize(wedge_res_size);
 		wedge_closed_.resize(wedge_res_size);
@@ -386,6 +1098,78 @@ PinarSampler::PinarSampler(size_t edge_res_size, size_t wedge_res_size)
 
 PinarSampler::~PinarSampler(){}
 
+void PinarSampler::memory_usage(MemoryUsage* usage) const{
+	size_t wedges_bytes = hashed_bytes(open_wedges_);
+	for (const auto& open: open_wedges_){
+		wedges_bytes += vector_bytes(open.second);
+	}
+	usage->bytes[MEMORY_RESERVOIR] += vector_bytes(edge_reservoir_) + vector_bytes(wedge_reservoir_)
+			+ vector_bytes(wedge_closed_) + wedges_bytes;
+	usage->bytes[MEMORY_EDGE_INDEX] += hashed_bytes(edge_multiplicity_);
+	usage->bytes[MEMORY_GRAPH] += sub_graph_.memory_bytes();
+}
+
+// Number of slots to skip before the next one selected, when each slot is
+// selected independently with prob q (geometric distribution).
+unsigned long long PinarSampler::next_skip(double q){
+	if (q >= 1.0){
+		return 0;
+	}
+	if (q <= 0.0){
+		return numeric_limits<unsigned long long>::max() / 2;
+	}
+	double u_rand = 1.0 - rand_uniform(); // in (0,1]
+	double skip = floor(log(u_rand) / log1p(-q));
+	if (skip >= numeric_limits<unsigned long long>::max() / 2){
+		return numeric_limits<unsigned long long>::max() / 2;
+	}
+	return (unsigned long long)skip;
+}
+
+// The reservoir is a multiset of edges, the subgraph contains each distinct edge once.
+void PinarSampler::add_sampled_edge(const pair<int,int>& edge){
+	if (edge_multiplicity_[edge]++ == 0){
+		// new wedges centered in the two endpoints
+		tot_wedges_ += sub_graph_.degree(edge.first) + sub_graph_.degree(edge.second);
+		sub_graph_.add_edge(edge.first, edge.second);
+	}
+}
+
+void PinarSampler::remove_sampled_edge(const pair<int,int>& edge){
+	auto it = edge_multiplicity_.find(edge);
+	assert(it != edge_multiplicity_.end());
+	if (--it->second == 0){
+		edge_multiplicity_.erase(it);
+		sub_graph_.remove_edge(edge.first, edge.second);
+		tot_wedges_ -= sub_graph_.degree(edge.first) + sub_graph_.degree(edge.second);
+	}
+}
+
+void PinarSampler::index_wedge(int slot){
+	const pair<int,int>& ends = wedge_reservoir_[slot].second;
+	pair<int,int> key = make_pair(min(ends.first, ends.second), max(ends.first, ends.second));
+	open_wedges_[key].push_back(slot);
+}
+
+void PinarSampler::unindex_wedge(int slot){
+	const pair<int,int>& ends = wedge_reservoir_[slot].second;
+	pair<int,int> key = make_pair(min(ends.first, ends.second), max(ends.first, ends.second));
+	auto it = open_wedges_.find(key);
+	if (it == open_wedges_.end()){
+		return; // slot never filled
+	}
+	vector<int>& slots = it->second;
+	auto pos = find(slots.begin(), slots.end(), slot);
+	if (pos == slots.end()){
+		return;
+	}
+	*pos = slots.back();
+	slots.pop_back();
+	if (slots.empty()){
+		open_wedges_.erase(it);
+	}
+}
+
 
 double PinarSampler::get_triangle_est(){
 	return fraction_closed_*t_*t_/
@@ -403,52 +1187,36 @@ void PinarSampler::exec_operation(const EdgeUpdate& update){
 
 	pair<int,int> edge = make_pair(min_n, max_n);
 
-	long long int closed = 0;
-
-	// Check if closing wedges
-	for (int i = 0; i<wedge_reservoir_.size(); i++){
-		const pair<int,pair<int,int>> &wedge = wedge_reservoir_[i];
-
-		if ((wedge.second.first == max_n && wedge.second.second == min_n)
-				||(wedge.second.first == min_n && wedge.second.second == max_n)
-		){
-				wedge_closed_[i] = true;
-
+	// Check if closing wedges (only open wedges are indexed, a closed one stays closed until replaced)
+	auto closing = open_wedges_.find(edge);
+	if (closing != open_wedges_.end()){
+		for (const auto& slot: closing->second){
+			assert(!wedge_closed_[slot]);
+			wedge_closed_[slot] = true;
 		}
-		closed += (wedge_closed_[i] ? 1 : 0);
+		closed_ += closing->second.size();
+		open_wedges_.erase(closing);
 	}
 
 
-
-	// Update edge reservoir
+	// Update edge reservoir: each slot is replaced independently with prob 1/t,
+	// jump directly to the replaced slots.
 	bool updated = false;
-	for (int i = 0; i<edge_reservoir_.size(); i++){
-		double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
-		if (u_rand <= 1.0/t_){
-			edge_reservoir_[i] = edge;
-			updated = true;
+	double q_edge = 1.0/t_;
+	for (unsigned long long i = next_skip(q_edge); i < edge_res_size_; i += 1 + next_skip(q_edge)){
+		if (t_ > 1){ // all slots are filled by the first edge
+			remove_sampled_edge(edge_reservoir_[i]);
 		}
+		edge_reservoir_[i] = edge;
+		add_sampled_edge(edge);
+		updated = true;
 	}
 
 	if(updated){
-		// count total num of wedges
-		UDynGraph sub_graph;
-		for (const auto& e: edge_reservoir_){
-			sub_graph.add_edge(e.first, e.second);
-		}
-		vector<int> nodes;
-		sub_graph.nodes(&nodes);
-
-		tot_wedges_ = 0;
-		for (const auto& n:nodes){
-			int deg = sub_graph.degree(n);
-			tot_wedges_+= (deg*(deg-1))/2;
-		}
-
 		// get new wedges with this edge...
 		vector<pair<int,pair<int,int>>> new_wedges;
 		vector<int> neighbors_min;
-		sub_graph.neighbors(min_n, &neighbors_min);
+		sub_graph_.neighbors(min_n, &neighbors_min);
 		for (const auto & neighbor: neighbors_min){
 			// wedge min_n-neighbor, min_n-max_n
 			if (neighbor != max_n){
@@ -456,7 +1224,7 @@ void PinarSampler::exec_operation(const EdgeUpdate& update){
 			}
 		}
 		vector<int> neighbors_max;
-		sub_graph.neighbors(max_n, &neighbors_max);
+		sub_graph_.neighbors(max_n, &neighbors_max);
 		for (const auto & neighbor: neighbors_max){
 			// wedge max_n-neighbor, max_n-min_n
 			if (neighbor != min_n){
@@ -464,17 +1232,19 @@ void PinarSampler::exec_operation(const EdgeUpdate& update){
 			}
 		}
 
-		for (int i = 0; i<wedge_reservoir_.size(); i++){
-			double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
-			if (u_rand <= 1.0*new_wedges.size()/tot_wedges_){
-				wedge_reservoir_[i] = new_wedges[rand()%new_wedges.size()];
-				closed -= (wedge_closed_[i] ? 1 : 0);
-				wedge_closed_[i] = false; // This make absolutely no sense but it is done in ali pinar paper So I implemented it as stated. ****
-				closed += (wedge_closed_[i] ? 1 : 0);
+		double q_wedge = new_wedges.empty() ? 0.0 : 1.0*new_wedges.size()/tot_wedges_;
+		for (unsigned long long i = next_skip(q_wedge); i < wedge_res_size_; i += 1 + next_skip(q_wedge)){
+			if (wedge_closed_[i]){
+				closed_--;
+			} else {
+				unindex_wedge(i);
 			}
+			wedge_reservoir_[i] = new_wedges[rand_int(new_wedges.size())];
+			wedge_closed_[i] = false; // This make absolutely no sense but it is done in ali pinar paper So I implemented it as stated. ****
+			index_wedge(i);
 		}
 
-		fraction_closed_ = 1.0*closed/ wedge_reservoir_.size();
+		fraction_closed_ = 1.0*closed_/ wedge_reservoir_.size();
 	}
 
 }
@@ -11,12 +11,22 @@
 #include "GraphScheduler.h"
 #include "UDynGraph.h"
 #include "TriangleCounter.h"
+#include "Summary.h"
+#include "MemoryUsage.h"
+#include "FlatEdgeSet.h"
 
 #include <unordered_set>
+#include <deque>
+#include <random>
 
 
 using namespace std;
 
+// Uniform in [0,1)
+inline double uniform_01(mt19937& rng){
+	return rng() / 4294967296.0;
+}
+
 class GraphSampler {
 public:
 	GraphSampler(TriangleCounter* counter);
@@ -25,10 +35,40 @@ public:
 public:
 	// Given the update (i.e. add or remove edge) execute it in the underlying graph according to the sampling
 	virtual void exec_operation(const EdgeUpdate& update) = 0;
+	// Executes the updates in order (by default one exec_operation each)
+	virtual void exec_batch(const vector<EdgeUpdate>& updates);
 	virtual double get_triangle_est() = 0;
 	virtual double get_triangle_est_local(int n) = 0;
 
+	// Whole state of the sampler and of its counter. Return false if not
+	// supported by the sampler (or, for load, if the snapshot is not valid).
+	virtual bool save(SnapshotWriter* out) const;
+	virtual bool load(SnapshotReader* in);
+	// Mergeable summary of the stream so far. Returns false if not supported
+	// by the sampler.
+	virtual bool summary(EdgeSummary* out) const;
+	// Adds the estimated heap bytes of the structures of the sampler and of
+	// its counter (by default only the counter).
+	virtual void memory_usage(MemoryUsage* usage) const;
+
+	// Reseeds the generator, seeded from rand() at construction
+	inline void seed(unsigned int seed){
+		rng_.seed(seed);
+	}
+
 	TriangleCounter* counter_; // The underlying graph used to execute the operations need to be allocated/deallocated by the callee
+
+protected:
+	inline double rand_uniform(){
+		return uniform_01(rng_);
+	}
+	inline unsigned int rand_int(unsigned int n){
+		return rng_()%n;
+	}
+	void save_rng(SnapshotWriter* out) const;
+	bool load_rng(SnapshotReader* in);
+
+	mt19937 rng_; // each sampler has its own generator (samplers can run in parallel)
 };
 
 class FixedPSampler: public GraphSampler {
@@ -39,12 +79,54 @@ public:
 	void exec_operation(const EdgeUpdate& update);
 	double get_triangle_est();
 	double get_triangle_est_local(int n);
+	bool save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
 
 private:
 	double p_;
 	bool use_sample_and_hold_;
 };
 
+// Exact counts of fully dynamic streams, without sampling: the whole graph is
+// kept in a FlatEdgeSet and in adjacency vectors indexed by node id, the
+// local counts in a vector indexed by node id. Each update probes the edge
+// set with the neighbors of its endpoint of smaller degree. Memory is O(max
+// node id + edges), meant for graphs with (mostly) dense ids. No counter.
+class ExactSampler: public GraphSampler {
+public:
+	explicit ExactSampler(bool local);
+	virtual ~ExactSampler();
+
+	void exec_operation(const EdgeUpdate& update);
+	double get_triangle_est();
+	double get_triangle_est_local(int n);
+	void memory_usage(MemoryUsage* usage) const;
+
+	inline unsigned long long triangles() const {
+		return triangles_;
+	}
+	inline int num_edges() const {
+		return edges_.size();
+	}
+	// Nodes that appeared in an addition, in order of appearance
+	inline const vector<int>& nodes() const {
+		return nodes_;
+	}
+
+private:
+	// Adds (sign 1) or removes (sign -1) the triangles of the edge u,v
+	void update_triangles(int u, int v, int sign);
+	void add_node(int u);
+
+	bool local_;
+	unsigned long long triangles_;
+	FlatEdgeSet edges_;
+	vector<vector<int>> adjacency_;
+	vector<unsigned long long> triangles_local_;
+	vector<bool> seen_;
+	vector<int> nodes_;
+};
+
 // ONLY ADDITIONS
 class ReservoirSampler: public GraphSampler {
 public:
@@ -54,16 +136,54 @@ public:
 	void exec_operation(const EdgeUpdate& update);
 	double get_triangle_est();
 	double get_triangle_est_local(int n);
+	bool save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
+	bool summary(EdgeSummary* out) const;
+
+	// The reservoir size becomes the largest that keeps memory_bytes() within
+	// the budget (to be called before the first update).
+	void set_memory_budget(size_t bytes);
+	// Estimated heap bytes of the sample: reservoir, edge index, graph and
+	// edge weights. Not the local counts, kept for every node ever seen.
+	size_t memory_bytes() const;
+	void memory_usage(MemoryUsage* usage) const;
 
 private:
 	void add_reservoir(const pair<int,int> edge);
 	void delete_reservoir(const pair<int,int> edge);
+	void fit_memory_budget();
 
 	bool use_sample_and_hold_;
+	size_t memory_budget_; // 0 if the reservoir size is fixed
+
+	unsigned long long reservoir_size_;
+	vector<pair<int,int>> reservoir_; // the slot of each edge in the counter is its position
+};
+
+
+// ONLY ADDITIONS. Keeps the reservoir_size edges with the smallest hash (the
+// same for the same edge in all the streams with the same hash_seed), so the
+// summaries of overlapping streams can be merged (see EdgeSummary). Each
+// triangle of the sample is weighted by 1 / threshold^3, where the threshold
+// is the smallest hash of the edges not in the sample.
+class CoordinatedSampler: public GraphSampler {
+public:
+	CoordinatedSampler(size_t reservoir_size, unsigned long long hash_seed, TriangleCounter* counter);
+	virtual ~CoordinatedSampler();
+
+	void exec_operation(const EdgeUpdate& update);
+	double get_triangle_est();
+	double get_triangle_est_local(int n);
+	bool save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
+	bool summary(EdgeSummary* out) const;
+	void memory_usage(MemoryUsage* usage) const;
 
+private:
 	unsigned long long reservoir_size_;
-	vector<pair<int,int>> reservoir_;
-	unordered_map<pair<int,int>, int> reservoir_map_;
+	unsigned long long hash_seed_;
+	double threshold_;
+	vector<pair<double, pair<int,int>>> reservoir_; // max-heap of (hash, edge)
 };
 
 
@@ -76,23 +196,135 @@ public:
 	void exec_operation(const EdgeUpdate& update);
 	double get_triangle_est();
 	double get_triangle_est_local(int n);
-
-private:
+	bool save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
+
+	// The reservoir size becomes the largest that keeps memory_bytes() within
+	// the budget (to be called before the first update).
+	void set_memory_budget(size_t bytes);
+	// Estimated heap bytes of the sample: reservoir, edge index, graph and
+	// edge weights. Not the local counts, kept for every node ever seen.
+	size_t memory_bytes() const;
+	void memory_usage(MemoryUsage* usage) const;
+
+protected:
 	void add_reservoir(const pair<int,int> edge);
 	void delete_reservoir(const pair<int,int> edge);
+	void fit_memory_budget();
+
+	size_t memory_budget_; // 0 if the reservoir size is fixed
 
   double prob_sampling_triangle() const;
 
+  // last value of prob_sampling_triangle() and the state it was computed for
+  mutable bool prob_cache_valid_;
+  mutable unsigned long long prob_cache_s_;
+  mutable unsigned long long prob_cache_d_;
+  mutable size_t prob_cache_m_;
+  mutable double prob_cache_;
+
 
   unsigned long long d_i_; //counter used by the algorithm
   unsigned long long d_o_; //counter used by the algorithm
 	unsigned long long reservoir_size_;
 
-	vector<pair<int,int>> reservoir_;
-	unordered_map<pair<int,int>, int> reservoir_map_;
+	vector<pair<int,int>> reservoir_; // the slot of each edge in the counter is its position
   unordered_set<pair<int,int>> all_edges_; //used only for debug not stored!
 };
 
+// Shin et al. "Think before you discard" (ThinkD-Acc). Every addition or
+// deletion first updates the weighted counts with the triangles it forms with
+// the current sample, weighted by 1 / Pr[both other edges sampled], then the
+// sample is updated by random pairing as in ReservoirAddRemSampler. Deletions
+// only subtract weight: the unweighted count of the counter is of the
+// triangles found at the additions (see sample_triangles for the ones of the
+// sample), and the running (local) estimates can be negative.
+class ThinkDSampler: public GraphSampler {
+public:
+	ThinkDSampler(size_t reservoir_size, TriangleCounter* counter);
+	virtual ~ThinkDSampler();
+
+	void exec_operation(const EdgeUpdate& update);
+	double get_triangle_est();
+	double get_triangle_est_local(int n);
+	bool save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
+	void memory_usage(MemoryUsage* usage) const;
+
+	// Triangles with all the edges in the sample
+	inline unsigned long long sample_triangles() const {
+		return sample_triangles_;
+	}
+
+private:
+	void add_reservoir(const pair<int,int> edge);
+	void delete_reservoir(const pair<int,int> edge);
+
+	// Prob that two edges of the graph are both in the sample
+	double prob_sampling_wedge() const;
+
+	unsigned long long d_i_; // deletions in the sample not compensated yet
+	unsigned long long d_o_; // deletions out of the sample not compensated yet
+	unsigned long long reservoir_size_;
+	unsigned long long sample_triangles_;
+
+	vector<pair<int,int>> reservoir_; // the slot of each edge in the counter is its position
+};
+
+// Shin "WRS: Waiting Room Sampling for accurate triangle counting in real
+// graph streams" (ICDM'17). ONLY ADDITIONS. The most recent edges are always
+// kept in a FIFO waiting room, the edges leaving it are reservoir sampled.
+// Each new edge counts the triangles closed with the sample, weighted by the
+// inverse of the prob of its two other edges being sampled.
+class WaitingRoomSampler: public GraphSampler {
+public:
+	WaitingRoomSampler(size_t memory_size, double waiting_room_fraction, TriangleCounter* counter);
+	virtual ~WaitingRoomSampler();
+
+	void exec_operation(const EdgeUpdate& update);
+	double get_triangle_est();
+	double get_triangle_est_local(int n);
+	void memory_usage(MemoryUsage* usage) const;
+
+private:
+	// Prob that the wedge of the new edge with n is sampled
+	double prob_sampling_wedge(int u, int v, int n) const;
+
+	unsigned long long waiting_room_size_;
+	unsigned long long reservoir_size_;
+	unsigned long long popped_; // edges that left the waiting room so far
+
+	deque<pair<int,int>> waiting_room_;
+	vector<pair<int,int>> reservoir_; // the slot of each edge in the counter is its position
+};
+
+// Triangles among the edges arrived in the last window_length time units
+// (EdgeUpdate.time). Edges expire as deletions of ReservoirAddRemSampler: the
+// sampled ones are removed from the reservoir, the others are only counted.
+// Memory: the reservoir, one counter per distinct timestamp in the window and
+// the arrival time of the sampled edges (at most twice the reservoir size,
+// the entries of the edges evicted from the reservoir are dropped in bulk).
+// ASSUMES: only additions, non-decreasing timestamps, and an edge is not added
+// again while it is in the window.
+class SlidingWindowSampler: public ReservoirAddRemSampler {
+public:
+	SlidingWindowSampler(size_t reservoir_size, int window_length, TriangleCounter* counter);
+	virtual ~SlidingWindowSampler();
+
+	void exec_operation(const EdgeUpdate& update);
+	bool save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
+	void memory_usage(MemoryUsage* usage) const;
+
+private:
+	// Deletes the edges with time <= now - window_length
+	void expire(int now);
+
+	int window_length_;
+	deque<pair<int, unsigned long long>> arrivals_; // (time, number of edges arrived at that time)
+	deque<pair<int, pair<int,int>>> sampled_; // (time, edge) of the edges that entered the reservoir
+};
+
 // Ali pinar "A space efficient streaming algorithm for estimating transitivity"
 // TKDD paper.
 class PinarSampler: public GraphSampler {
@@ -106,13 +338,20 @@ public:
 		return 0;
 		// Not implemented by this algorithm
 	}
+	void memory_usage(MemoryUsage* usage) const;
 
 private:
 	//void add_reservoir(const pair<int,int> edge);
 	//void delete_reservoir(const pair<int,int> edge);
+	unsigned long long next_skip(double q);
+	void add_sampled_edge(const pair<int,int>& edge);
+	void remove_sampled_edge(const pair<int,int>& edge);
+	void index_wedge(int slot);
+	void unindex_wedge(int slot);
 
 	unsigned long long t_;
 	unsigned long long tot_wedges_;
+	unsigned long long closed_; // number of closed wedges in the wedge reservoir
 	double fraction_closed_;
 
 
@@ -121,6 +360,11 @@ private:
 	vector<pair<int,int>> edge_reservoir_;
 	vector<pair<int, pair<int,int>>> wedge_reservoir_; // wedge represented as (u, (x,y)) for u-x u-y
 	vector<bool> wedge_closed_;
+	// distinct edges of edge_reservoir_, maintained as slots are replaced
+	UDynGraph sub_graph_;
+	unordered_map<pair<int,int>, int> edge_multiplicity_;
+	// open endpoints (x,y) with x<y -> slots of the stored wedges that are not closed yet
+	unordered_map<pair<int,int>, vector<int>> open_wedges_;
 
 };
 
@@ -142,14 +386,14 @@ public:
 		is_triangle = false;
 	}
 
-	void add_edge(int u, int v){
+	void add_edge(int u, int v, mt19937& rng){
 		int min_u = int(min(u,v));
 		int max_u = int(max(u,v));
 		u = min_u;
 		v = max_u;
 
 		t++;
-		double u_rand = (double)rand() / ((double)RAND_MAX+1.0);
+		double u_rand = uniform_01(rng);
 		if (u_rand<= 1.0/t){
 			e1.first = u;
 			e1.second = v;
@@ -159,7 +403,7 @@ public:
 		} else {
 			if (e1.first == u || e1.second == u || e1.first == v || e1.second == v){
 				c++;
-				double u_rand2 = (double)rand() / ((double)RAND_MAX+1.0);
+				double u_rand2 = uniform_01(rng);
 				if (u_rand2<= 1.0/c){
 					e2.first = u;
 					e2.second = v;
@@ -187,7 +431,7 @@ public:
 	void exec_operation(const EdgeUpdate& update){
 		t_ += 1;
 		for (auto& est: estimators){
-			est.add_edge(update.node_u, update.node_v);
+			est.add_edge(update.node_u, update.node_v, rng_);
 		}
 	}
 	double get_triangle_est(){
@@ -203,6 +447,9 @@ public:
 		return 0;
 		// Not implemented by this algorithm
 	}
+	void memory_usage(MemoryUsage* usage) const{
+		usage->bytes[MEMORY_RESERVOIR] += vector_bytes(estimators);
+	}
 
 private:
 	//void add_reservoir(const pair<int,int> edge);
@@ -6,6 +6,7 @@
  */
 
 #include "GraphScheduler.h"
+#include "Profile.h"
 #include <cstring>
 #include <cassert>
 #include <iostream>
@@ -16,17 +17,19 @@ GraphScheduler::~GraphScheduler() {
 	this->file_stream_.close();
 }
 
-GraphScheduler::GraphScheduler(const string& file_name, bool store_time) {
+GraphScheduler::GraphScheduler(const string& file_name, bool store_time, unsigned long long start_offset) {
 
 	store_time_ = store_time;
 	file_stream_.open(file_name.c_str(), ios_base::in);
-	retrieve_next_chunk();
-	assert(this->has_next());
+	file_stream_.seekg(start_offset);
+	read_offset_ = offset_ = start_offset;
+	retrieve_next_chunk(); // nothing left if start_offset is the end of the file
 	add_count = 0;
 	remove_count = 0;
 }
 
 void GraphScheduler::retrieve_next_chunk() {
+	PROFILE_PHASE(PHASE_PARSE);
 
 	std::string delimiter = " ";
 	string line;
@@ -38,6 +41,7 @@ void GraphScheduler::retrieve_next_chunk() {
 	int read = 0;
 
 	while (read++ < CHUNK_SIZE && getline(file_stream_, line)) {
+		read_offset_ += line.size() + 1;
 		tokens.clear();
 		//cout <<" READING "<<line<< endl;
 		size_t pos = 0;
@@ -86,6 +90,7 @@ void GraphScheduler::retrieve_next_chunk() {
 			continue;
 		}
 
+		end_offsets_.push(read_offset_);
 		if (store_time_){
 			edge_queue_.push(next_edge);
 		} else {
@@ -124,6 +129,9 @@ EdgeUpdate GraphScheduler::next_update() {
 		edge_queue.time = 0;
 	}
 
+	offset_ = end_offsets_.front();
+	end_offsets_.pop();
+
 	if (edge_queue.is_add) {
 		++add_count;
 	} else {
@@ -39,10 +39,16 @@ typedef struct EdgeUpdateNoTime {
 
 class GraphScheduler {
 public:
-	GraphScheduler(const string& file_name, bool store_time_);
+	// Reads the updates from start_offset (bytes) on.
+	GraphScheduler(const string& file_name, bool store_time_, unsigned long long start_offset = 0);
 	virtual ~GraphScheduler();
 
 	EdgeUpdate next_update();
+	// Offset in the file right after the last update returned (where to
+	// restart from to get the following ones).
+	inline unsigned long long offset() const {
+		return offset_;
+	}
 	inline bool has_next() {
 		if (store_time_) {
 			return !edge_queue_.empty();
@@ -59,6 +65,9 @@ private:
 	ifstream file_stream_;
 	queue<EdgeUpdate> edge_queue_;
 	queue<EdgeUpdateNoTime> edge_queue_no_time_;
+	queue<unsigned long long> end_offsets_; // offset after the line of each update in the queue
+	unsigned long long read_offset_; // bytes read from the file
+	unsigned long long offset_;
 };
 
 #endif /* GRAPHSCHEDULER_H_ */
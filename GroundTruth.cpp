@@ -0,0 +1,187 @@
+#include "GroundTruth.h"
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+// Nodes taken at a time by the threads of count_triangles_exact
+#define EXACT_CHUNK 256
+
+GroundTruthWriter::GroundTruthWriter(const string& file_name) {
+	file_ = fopen(file_name.c_str(), "wb");
+	if (file_ != NULL) {
+		unsigned long long length = strlen(GROUND_TRUTH_MAGIC);
+		fwrite(&length, sizeof(length), 1, file_);
+		fwrite(GROUND_TRUTH_MAGIC, 1, length, file_);
+	}
+}
+
+GroundTruthWriter::~GroundTruthWriter() {
+	if (file_ != NULL) {
+		fclose(file_);
+	}
+}
+
+bool GroundTruthWriter::write(const GroundTruthRecord& record) {
+	assert(ok());
+	assert(record.nodes.size() == record.local_triangles.size());
+	unsigned long long num_nodes = record.nodes.size();
+	bool ok = fwrite(&record.op_count, sizeof(record.op_count), 1, file_) == 1
+			&& fwrite(&record.triangles, sizeof(record.triangles), 1, file_) == 1
+			&& fwrite(&num_nodes, sizeof(num_nodes), 1, file_) == 1
+			&& fwrite(record.nodes.data(), sizeof(int), num_nodes, file_) == num_nodes
+			&& fwrite(&num_nodes, sizeof(num_nodes), 1, file_) == 1
+			&& fwrite(record.local_triangles.data(), sizeof(unsigned long long), num_nodes, file_) == num_nodes;
+	return fflush(file_) == 0 && ok;
+}
+
+bool GroundTruthReader::open(const string& file_name) {
+	string magic;
+	if (!in_.open(file_name) || !in_.get_string(&magic) || magic != GROUND_TRUTH_MAGIC) {
+		return false;
+	}
+	has_next_ = in_.get(&next_.op_count) && in_.get(&next_.triangles)
+			&& in_.get_vector(&next_.nodes) && in_.get_vector(&next_.local_triangles);
+	return true;
+}
+
+bool GroundTruthReader::seek(unsigned long long op_count, GroundTruthRecord* record) {
+	while (has_next_ && next_.op_count <= op_count) {
+		bool found = next_.op_count == op_count;
+		if (found) {
+			swap(*record, next_);
+		}
+		has_next_ = in_.get(&next_.op_count) && in_.get(&next_.triangles)
+				&& in_.get_vector(&next_.nodes) && in_.get_vector(&next_.local_triangles);
+		if (found) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void count_triangles_exact(const vector<pair<int,int>>& edges, const vector<int>& nodes,
+		bool local, int num_threads, GroundTruthRecord* record) {
+	size_t num_nodes = nodes.size();
+	// Edges as pairs of node indices
+	vector<pair<int,int>> indexed(edges.size());
+	vector<unsigned int> degree(num_nodes, 0);
+	for (size_t i = 0; i < edges.size(); i++) {
+		int u = lower_bound(nodes.begin(), nodes.end(), edges[i].first) - nodes.begin();
+		int v = lower_bound(nodes.begin(), nodes.end(), edges[i].second) - nodes.begin();
+		assert((size_t)u < num_nodes && nodes[u] == edges[i].first);
+		assert((size_t)v < num_nodes && nodes[v] == edges[i].second);
+		indexed[i] = make_pair(u, v);
+		degree[u]++;
+		degree[v]++;
+	}
+
+	// Nodes renumbered by rank in (degree, id) order
+	vector<int> by_rank(num_nodes);
+	for (size_t i = 0; i < num_nodes; i++) {
+		by_rank[i] = i;
+	}
+	sort(by_rank.begin(), by_rank.end(), [&degree](int a, int b) {
+		return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+	});
+	vector<int> rank(num_nodes);
+	for (size_t i = 0; i < num_nodes; i++) {
+		rank[by_rank[i]] = i;
+	}
+
+	// CSR of the out neighbors (higher rank), sorted
+	vector<size_t> offsets(num_nodes + 1, 0);
+	for (auto& edge: indexed) {
+		edge = make_pair(min(rank[edge.first], rank[edge.second]), max(rank[edge.first], rank[edge.second]));
+		offsets[edge.first + 1]++;
+	}
+	for (size_t i = 0; i < num_nodes; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+	vector<int> neighbors(indexed.size());
+	vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+	for (const auto& edge: indexed) {
+		neighbors[fill[edge.first]++] = edge.second;
+	}
+	vector<pair<int,int>>().swap(indexed);
+	for (size_t i = 0; i < num_nodes; i++) {
+		sort(neighbors.begin() + offsets[i], neighbors.begin() + offsets[i + 1]);
+	}
+
+	// Each thread counts the triangles of the nodes it takes (as the lowest
+	// node). The local counts are shared by the threads: the ones of u and v
+	// are summed over their intersection and added once, the third node is
+	// added at each triangle (relaxed atomic adds, only the totals matter).
+	num_threads = max(1, num_threads);
+	vector<unsigned long long> triangles(num_threads, 0);
+	vector<unsigned long long> local_counts(local ? num_nodes : 0, 0);
+	unsigned long long* counts = local_counts.data();
+	atomic<size_t> next_node(0);
+	auto count = [&](int thread_id) {
+		unsigned long long found = 0;
+		size_t first;
+		while ((first = next_node.fetch_add(EXACT_CHUNK)) < num_nodes) {
+			size_t last = min(num_nodes, first + EXACT_CHUNK);
+			for (size_t u = first; u < last; u++) {
+				const int* u_begin = neighbors.data() + offsets[u];
+				const int* u_end = neighbors.data() + offsets[u + 1];
+				unsigned long long found_u = 0;
+				for (const int* v = u_begin; v != u_end; v++) {
+					// Neighbors of u after v and out neighbors of v, both sorted
+					const int* a = v + 1;
+					const int* b = neighbors.data() + offsets[*v];
+					const int* b_end = neighbors.data() + offsets[*v + 1];
+					unsigned long long found_uv = 0;
+					while (a != u_end && b != b_end) {
+						if (*a < *b) {
+							a++;
+						} else if (*b < *a) {
+							b++;
+						} else {
+							found_uv++;
+							if (local) {
+								__atomic_fetch_add(&counts[*a], 1, __ATOMIC_RELAXED);
+							}
+							a++;
+							b++;
+						}
+					}
+					if (local && found_uv > 0) {
+						__atomic_fetch_add(&counts[*v], found_uv, __ATOMIC_RELAXED);
+					}
+					found_u += found_uv;
+				}
+				if (local && found_u > 0) {
+					__atomic_fetch_add(&counts[u], found_u, __ATOMIC_RELAXED);
+				}
+				found += found_u;
+			}
+		}
+		triangles[thread_id] = found;
+	};
+	vector<thread> workers;
+	for (int t = 1; t < num_threads; t++) {
+		workers.push_back(thread(count, t));
+	}
+	count(0);
+	for (auto& worker: workers) {
+		worker.join();
+	}
+
+	record->triangles = 0;
+	for (const auto& found: triangles) {
+		record->triangles += found;
+	}
+	record->nodes.clear();
+	record->local_triangles.clear();
+	if (local) {
+		record->nodes = nodes;
+		record->local_triangles.resize(num_nodes);
+		for (size_t i = 0; i < num_nodes; i++) {
+			record->local_triangles[i] = local_counts[rank[i]];
+		}
+	}
+}
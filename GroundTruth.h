@@ -0,0 +1,73 @@
+#ifndef GROUNDTRUTH_H_
+#define GROUNDTRUTH_H_
+
+#include "Snapshot.h"
+
+#include <vector>
+#include <string>
+#include <cstdio>
+
+using namespace std;
+
+#define GROUND_TRUTH_MAGIC "TRIEST-TRUTH-1"
+
+// Exact counts of the graph after the first op_count updates of a stream.
+typedef struct GroundTruthRecord {
+	unsigned long long op_count;
+	unsigned long long triangles;
+	// Nodes that appeared in an addition so far (as the nodes of UDynGraph),
+	// in increasing order, and their local triangle counts. Empty if the
+	// file has only the global counts.
+	vector<int> nodes;
+	vector<unsigned long long> local_triangles;
+} GroundTruthRecord;
+
+// Ground truth files (written by ExactCounting): the magic string then one
+// record per checkpoint in increasing op_count, in the raw layout of
+// Snapshot.h. Records are appended as they are computed.
+class GroundTruthWriter {
+public:
+	explicit GroundTruthWriter(const string& file_name);
+	virtual ~GroundTruthWriter();
+
+	bool ok() const {
+		return file_ != NULL;
+	}
+	// Returns false on error.
+	bool write(const GroundTruthRecord& record);
+
+private:
+	FILE* file_;
+};
+
+// Reads the records in order from the mmap-ed file, so only the pages of the
+// current record are needed in memory.
+class GroundTruthReader {
+public:
+	// Returns false if the file cannot be read or is not a ground truth file.
+	bool open(const string& file_name);
+
+	// Reads up to the record of op_count. Returns false if there is none
+	// (the records before it are skipped, the following ones can still be
+	// read).
+	bool seek(unsigned long long op_count, GroundTruthRecord* record);
+
+private:
+	SnapshotReader in_;
+	GroundTruthRecord next_; // read ahead, valid if has_next_
+	bool has_next_;
+};
+
+// Exact global and (if local) local triangle counts of the graph with the
+// given edges (distinct, u != v). nodes are the nodes to report, in
+// increasing order, including all the endpoints of the edges. The edges are
+// oriented from the lower to the higher node in (degree, id) order and
+// stored as a CSR, so every node has O(sqrt(m)) out neighbors. Each triangle
+// is found once, by the sorted intersection of the out neighbors of its two
+// lowest nodes. The nodes are split among num_threads threads. The local
+// counts are a single array of num_nodes counters shared by the threads, so
+// the memory does not grow with num_threads.
+void count_triangles_exact(const vector<pair<int,int>>& edges, const vector<int>& nodes,
+		bool local, int num_threads, GroundTruthRecord* record);
+
+#endif /* GROUNDTRUTH_H_ */
@@ -0,0 +1,113 @@
+#include "LatencyHistogram.h"
+#include <cassert>
+#include <cmath>
+#include <fstream>
+
+using namespace std;
+
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+LatencyHistogram::LatencyHistogram() : counts_(LATENCY_BUCKETS, 0), count_(0), max_(0) {
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other){
+	for (size_t i = 0; i < counts_.size(); i++){
+		counts_[i] += other.counts_[i];
+	}
+	count_ += other.count_;
+	max_ = max(max_, other.max_);
+}
+
+void LatencyHistogram::clear(){
+	if (count_ > 0){
+		fill(counts_.begin(), counts_.end(), 0);
+	}
+	count_ = max_ = 0;
+}
+
+unsigned long long LatencyHistogram::bucket_low(size_t bucket){
+	if (bucket < (1ull << LATENCY_SUB_BITS)){
+		return bucket;
+	}
+	int exponent = (bucket >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+	unsigned long long sub = bucket & ((1ull << LATENCY_SUB_BITS) - 1);
+	return ((1ull << LATENCY_SUB_BITS) + sub) << (exponent - LATENCY_SUB_BITS);
+}
+
+unsigned long long LatencyHistogram::bucket_high(size_t bucket){
+	if (bucket < (1ull << LATENCY_SUB_BITS)){
+		return bucket;
+	}
+	int exponent = (bucket >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+	return bucket_low(bucket) + (1ull << (exponent - LATENCY_SUB_BITS)) - 1;
+}
+
+unsigned long long LatencyHistogram::percentile(double q) const{
+	if (count_ == 0){
+		return 0;
+	}
+	unsigned long long rank = max(1ull, (unsigned long long)ceil(q * count_));
+	unsigned long long seen = 0;
+	for (size_t i = 0; i < counts_.size(); i++){
+		seen += counts_[i];
+		if (seen >= rank){
+			return min(bucket_high(i), max_);
+		}
+	}
+	return max_;
+}
+
+void LatencyHistogram::buckets(vector<unsigned long long>* low, vector<unsigned long long>* high,
+		vector<unsigned long long>* counts) const{
+	low->clear();
+	high->clear();
+	counts->clear();
+	for (size_t i = 0; i < counts_.size(); i++){
+		if (counts_[i] > 0){
+			low->push_back(bucket_low(i));
+			high->push_back(bucket_high(i));
+			counts->push_back(counts_[i]);
+		}
+	}
+}
+
+const char* UpdateLatencies::kind_name(int kind){
+	static const char* names[NUM_KINDS] = {"add_sample", "add_other", "rem_sample", "rem_other"};
+	return names[kind];
+}
+
+void UpdateLatencies::add_columns(Stats* stats){
+	vector<string> columns;
+	for (int kind = 0; kind < NUM_KINDS; kind++){
+		string name = kind_name(kind);
+		columns.push_back(name + "_count");
+		columns.push_back(name + "_p50_ns");
+		columns.push_back(name + "_p99_ns");
+		columns.push_back(name + "_p999_ns");
+		columns.push_back(name + "_max_ns");
+	}
+	stats->add_columns(columns, [this](vector<double>* values) {
+		for (int kind = 0; kind < NUM_KINDS; kind++){
+			LatencyHistogram& window = window_[kind];
+			values->push_back(window.count());
+			values->push_back(window.percentile(0.5));
+			values->push_back(window.percentile(0.99));
+			values->push_back(window.percentile(0.999));
+			values->push_back(window.max_value());
+			total_[kind].merge(window);
+			window.clear();
+		}
+	});
+}
+
+bool UpdateLatencies::write(const string& file_name) const{
+	ofstream out(file_name.c_str());
+	vector<unsigned long long> low, high, counts;
+	for (int kind = 0; kind < NUM_KINDS; kind++){
+		total_[kind].buckets(&low, &high, &counts);
+		for (size_t i = 0; i < counts.size(); i++){
+			out << kind_name(kind) << "\t" << low[i] << "\t" << high[i] << "\t" << counts[i] << "\n";
+		}
+	}
+	return out.good();
+}
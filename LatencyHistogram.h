@@ -0,0 +1,94 @@
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include "Stats.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+// Sub-buckets per power of two: values are counted with relative error < 1/16
+#define LATENCY_SUB_BITS 4
+
+// Counts of values (e.g. nanoseconds) in log-linear buckets as in
+// HdrHistogram: the values below 2^LATENCY_SUB_BITS are exact, each larger
+// power of two range is split in 2^LATENCY_SUB_BITS buckets. Recording is a
+// few instructions and histograms of different runs can be merged.
+class LatencyHistogram {
+public:
+	LatencyHistogram();
+
+	inline void record(unsigned long long value){
+		counts_[bucket(value)]++;
+		count_++;
+		max_ = max(max_, value);
+	}
+	void merge(const LatencyHistogram& other);
+	void clear();
+
+	inline unsigned long long count() const {
+		return count_;
+	}
+	inline unsigned long long max_value() const {
+		return max_;
+	}
+	// Smallest value (up to the bucket precision) such that a fraction q of
+	// the values is not larger. 0 if there are no values.
+	unsigned long long percentile(double q) const;
+
+	// Non-empty buckets: lowest value, highest value and count of each one
+	void buckets(vector<unsigned long long>* low, vector<unsigned long long>* high,
+			vector<unsigned long long>* counts) const;
+
+	static inline size_t bucket(unsigned long long value){
+		if (value < (1ull << LATENCY_SUB_BITS)){
+			return value;
+		}
+		int exponent = 63 - __builtin_clzll(value);
+		size_t sub = (value >> (exponent - LATENCY_SUB_BITS)) & ((1ull << LATENCY_SUB_BITS) - 1);
+		return ((exponent - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+	}
+	static unsigned long long bucket_low(size_t bucket);
+	static unsigned long long bucket_high(size_t bucket);
+
+private:
+	vector<unsigned long long> counts_;
+	unsigned long long count_;
+	unsigned long long max_;
+};
+
+// Latency of the updates of a run by kind: addition or removal, touching the
+// sample (the edge enters or leaves it) or not. Kept per stats window and for
+// the whole run.
+class UpdateLatencies {
+public:
+	enum Kind {
+		ADD_SAMPLE, ADD_OTHER, REM_SAMPLE, REM_OTHER, NUM_KINDS
+	};
+
+	inline void record(bool is_add, bool touched_sample, unsigned long long nanos){
+		Kind kind = is_add ? (touched_sample ? ADD_SAMPLE : ADD_OTHER)
+				: (touched_sample ? REM_SAMPLE : REM_OTHER);
+		window_[kind].record(nanos);
+	}
+
+	// Adds the columns count, p50, p99, p99.9 and max (nanoseconds) of each
+	// kind for the window. The window histograms are then added to the ones
+	// of the whole run.
+	void add_columns(Stats* stats);
+
+	// Writes the histograms of the whole run, a line per non-empty bucket:
+	// kind, lowest value, highest value, count. The files of several runs are
+	// merged by summing the counts of the same kind and lowest value.
+	bool write(const string& file_name) const;
+
+private:
+	static const char* kind_name(int kind);
+
+	LatencyHistogram window_[NUM_KINDS];
+	LatencyHistogram total_[NUM_KINDS];
+};
+
+#endif /* LATENCYHISTOGRAM_H_ */
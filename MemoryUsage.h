@@ -0,0 +1,83 @@
+#ifndef MEMORYUSAGE_H_
+#define MEMORYUSAGE_H_
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+
+using namespace std;
+
+// Estimates of the heap bytes used by the standard containers (libstdc++
+// layout, glibc malloc). All O(1).
+
+// Bytes of the malloc chunk serving a request (8 bytes header, 16 bytes
+// alignment, 32 bytes minimum).
+inline size_t allocation_bytes(size_t request){
+	size_t chunk = (request + 8 + 15) & ~(size_t)15;
+	return chunk < 32 ? 32 : chunk;
+}
+
+template <class T>
+inline size_t vector_bytes(const vector<T>& vec){
+	return vec.capacity() ? allocation_bytes(vec.capacity()*sizeof(T)) : 0;
+}
+
+inline size_t vector_bytes(const vector<bool>& vec){
+	return vec.capacity() ? allocation_bytes(vec.capacity()/8) : 0;
+}
+
+// deque: nodes of 512 bytes (or of one element) and the map of the nodes.
+template <class T>
+inline size_t deque_bytes(const deque<T>& deq){
+	size_t per_node = sizeof(T) < 512 ? 512/sizeof(T) : 1;
+	size_t nodes = deq.size()/per_node + 1;
+	return nodes*allocation_bytes(per_node*sizeof(T)) + allocation_bytes(max((size_t)8, nodes + 2)*sizeof(void*));
+}
+
+// unordered_set/map: bucket array plus one node per element (next pointer,
+// value and, for non integral keys, the cached hash).
+template <class C>
+inline size_t hashed_bytes(const C& container){
+	size_t node = sizeof(void*) + sizeof(typename C::value_type)
+			+ (is_integral<typename C::key_type>::value ? 0 : sizeof(size_t));
+	node = (node + 7) & ~(size_t)7;
+	return allocation_bytes(container.bucket_count()*sizeof(void*))
+			+ container.size()*allocation_bytes(node);
+}
+
+// Structures of the samplers and counters whose bytes are reported apart
+enum MemoryStructure {
+	MEMORY_RESERVOIR, // edges kept by the sampler (reservoir, waiting room, wedges, ...)
+	MEMORY_EDGE_INDEX, // edge -> slot index of TriangleCounter
+	MEMORY_GRAPH, // adjacency of the sample (UDynGraph)
+	MEMORY_LOCAL_COUNTS, // per node triangle counts
+	MEMORY_EDGE_WEIGHTS, // edge weights of TriangleCounter
+	NUM_MEMORY_STRUCTURES
+};
+
+// Estimated heap bytes of each structure, summed over the samplers and
+// counters that add themselves to it.
+struct MemoryUsage {
+	size_t bytes[NUM_MEMORY_STRUCTURES];
+
+	MemoryUsage() {
+		for (int structure = 0; structure < NUM_MEMORY_STRUCTURES; structure++){
+			bytes[structure] = 0;
+		}
+	}
+	size_t total() const {
+		size_t sum = 0;
+		for (int structure = 0; structure < NUM_MEMORY_STRUCTURES; structure++){
+			sum += bytes[structure];
+		}
+		return sum;
+	}
+	static const char* name(int structure){
+		static const char* names[NUM_MEMORY_STRUCTURES] = {"reservoir", "edge_index", "graph", "local_counts", "edge_weights"};
+		return names[structure];
+	}
+};
+
+#endif /* MEMORYUSAGE_H_ */
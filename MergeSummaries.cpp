@@ -0,0 +1,47 @@
+#include "Summary.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+	if (argc <= 4) {
+		cerr
+				<< "ERROR Requires at least 4 parameters. MergeSummaries random_seed (int); size of the merged sample (int); merged-summary-output-file; summary files written by RunCounting --summary (one or more)\n"
+				<< "Summaries of the R sampler can be merged only if built on disjoint edge streams, summaries of the H sampler (with the same seed) also if the streams overlap." << endl;
+		exit(1);
+	}
+
+	int random_seed = atoi(argv[1]);
+	mt19937 rng(random_seed);
+	unsigned long long size = atoll(argv[2]);
+	string output_file(argv[3]);
+
+	vector<EdgeSummary> summaries(argc-4);
+	for (int i = 4; i < argc; i++) {
+		if (!read_summary_file(argv[i], &summaries[i-4])) {
+			cerr << "ERROR " << argv[i] << " is not a summary file." << endl;
+			exit(1);
+		}
+	}
+
+	EdgeSummary merged;
+	if (!merge_summaries(summaries, size, rng, &merged)) {
+		cerr << "ERROR the summaries cannot be merged (different samplers or hash seeds, or overlapping streams)." << endl;
+		exit(1);
+	}
+	if (!write_summary_file(output_file, merged)) {
+		cerr << "ERROR cannot write " << output_file << endl;
+		exit(1);
+	}
+
+	cout << "summary\tsize_sample\ttriangles_est" << endl;
+	for (int i = 4; i < argc; i++) {
+		cout << argv[i] << "\t" << summaries[i-4].sample.size() << "\t" << summaries[i-4].triangle_est() << endl;
+	}
+	cout << output_file << "\t" << merged.sample.size() << "\t" << merged.triangle_est() << endl;
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "PartitionedSampler.h"
+#include <cassert>
+
+using namespace std;
+
+PartitionedSampler::PartitionedSampler(size_t num_workers, Partitioning partitioning, bool local, const SamplerFactory& factory)
+	: MultiSampler(num_workers, local, factory), partitioning_(partitioning){
+	seed_ = ((unsigned long long)rng_() << 32) | rng_();
+	batches_.resize(num_workers);
+	for (auto& batch: batches_){
+		parts_.push_back(&batch);
+	}
+}
+
+PartitionedSampler::~PartitionedSampler(){}
+
+int PartitionedSampler::worker(const EdgeUpdate& update) const{
+	unsigned long long num_workers = samplers_.size();
+	if (partitioning_ == EDGE_HASH){
+		return mix64(edge_to_id(update.node_u, update.node_v) ^ seed_) % num_workers;
+	}
+	int color_u = mix64((unsigned long long)update.node_u ^ seed_) % num_workers;
+	int color_v = mix64((unsigned long long)update.node_v ^ seed_) % num_workers;
+	return color_u == color_v ? color_u : -1;
+}
+
+void PartitionedSampler::exec_operation(const EdgeUpdate& update){
+	int w = worker(update);
+	if (w >= 0){
+		samplers_[w]->exec_operation(update);
+	}
+}
+
+void PartitionedSampler::exec_batch(const vector<EdgeUpdate>& updates){
+	for (auto& batch: batches_){
+		batch.clear();
+	}
+	for (const auto& update: updates){
+		int w = worker(update);
+		if (w >= 0){
+			batches_[w].push_back(update);
+		}
+	}
+	exec_parallel(parts_);
+}
+
+double PartitionedSampler::get_triangle_est(){
+	double sum = 0;
+	for (auto& sampler: samplers_){
+		sum += sampler->get_triangle_est();
+	}
+	return sum * samplers_.size() * samplers_.size();
+}
+
+double PartitionedSampler::get_triangle_est_local(int n){
+	double sum = 0;
+	for (auto& sampler: samplers_){
+		sum += sampler->get_triangle_est_local(n);
+	}
+	return sum * samplers_.size() * samplers_.size();
+}
@@ -0,0 +1,39 @@
+#ifndef PARTITIONEDSAMPLER_H_
+#define PARTITIONEDSAMPLER_H_
+
+#include "SamplerEnsemble.h"
+
+using namespace std;
+
+enum Partitioning {
+	EDGE_HASH, // each edge goes to worker h(u,v)
+	VERTEX_COLOR // edge goes to worker c if c(u) = c(v) = c, dropped otherwise
+};
+
+// The update stream is split among P workers, each one running its own
+// sampler on its part. A triangle is seen entirely by a single worker with
+// probability 1/P^2 (3 edges in the same worker, or 3 vertices with the same
+// colour), so P^2 times the sum of the workers estimates is unbiased.
+// Each worker should get 1/P of the total memory. The parts of a batch are
+// run in parallel by the persistent workers of MultiSampler.
+class PartitionedSampler: public MultiSampler {
+public:
+	PartitionedSampler(size_t num_workers, Partitioning partitioning, bool local, const SamplerFactory& factory);
+	virtual ~PartitionedSampler();
+
+	void exec_operation(const EdgeUpdate& update);
+	void exec_batch(const vector<EdgeUpdate>& updates);
+	double get_triangle_est();
+	double get_triangle_est_local(int n);
+
+private:
+	// Worker of the update or -1 if it is dropped
+	int worker(const EdgeUpdate& update) const;
+
+	Partitioning partitioning_;
+	unsigned long long seed_;
+	vector<vector<EdgeUpdate>> batches_; // part of the current batch of each worker
+	vector<const vector<EdgeUpdate>*> parts_; // &batches_[w], for exec_parallel
+};
+
+#endif /* PARTITIONEDSAMPLER_H_ */
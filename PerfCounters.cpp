@@ -0,0 +1,121 @@
+#include "PerfCounters.h"
+#include <iostream>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+PerfCounters::PerfCounters() {
+	for (int counter = 0; counter < NUM_PERF_COUNTERS; counter++){
+		fds_[counter] = -1;
+		last_[counter] = 0;
+	}
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	for (int counter = 0; counter < NUM_PERF_COUNTERS; counter++){
+		if (fds_[counter] >= 0){
+			close(fds_[counter]);
+		}
+	}
+#endif
+}
+
+void PerfCounters::names(vector<string>* names){
+	const char* counters[NUM_PERF_COUNTERS] = {"cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"};
+	names->assign(counters, counters + NUM_PERF_COUNTERS);
+	names->push_back("ipc");
+}
+
+#ifdef __linux__
+
+int PerfCounters::open(){
+	const unsigned int types[NUM_PERF_COUNTERS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+			PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+	const unsigned long long configs[NUM_PERF_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+			PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+	int num_available = 0;
+	for (int counter = 0; counter < NUM_PERF_COUNTERS; counter++){
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = types[counter];
+		attr.config = configs[counter];
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fds_[counter] = syscall(__NR_perf_event_open, &attr, 0 /*this process*/, -1 /*any cpu*/, -1, 0);
+		if (fds_[counter] >= 0){
+			num_available++;
+			read_counter(counter, &last_[counter]);
+		}
+	}
+	if (num_available < NUM_PERF_COUNTERS){
+		vector<string> counter_names;
+		names(&counter_names);
+		cerr << "WARNING hardware counters not available:";
+		for (int counter = 0; counter < NUM_PERF_COUNTERS; counter++){
+			if (fds_[counter] < 0){
+				cerr << " " << counter_names[counter];
+			}
+		}
+		cerr << " (see /proc/sys/kernel/perf_event_paranoid), reported as -1" << endl;
+	}
+	return num_available;
+}
+
+bool PerfCounters::read_counter(int counter, double* value) const{
+	unsigned long long data[3]; // value, time enabled, time running
+	if (read(fds_[counter], data, sizeof(data)) != sizeof(data)){
+		return false;
+	}
+	*value = data[2] > 0 ? (double)data[0] * data[1] / data[2] : 0;
+	return true;
+}
+
+#else
+
+int PerfCounters::open(){
+	cerr << "WARNING hardware counters not available on this system, reported as -1" << endl;
+	return 0;
+}
+
+bool PerfCounters::read_counter(int, double*) const{
+	return false;
+}
+
+#endif /* __linux__ */
+
+void PerfCounters::read_delta(vector<double>* values){
+	double delta[NUM_PERF_COUNTERS];
+	for (int counter = 0; counter < NUM_PERF_COUNTERS; counter++){
+		double value;
+		if (available(counter) && read_counter(counter, &value)){
+			delta[counter] = value - last_[counter];
+			last_[counter] = value;
+		} else {
+			delta[counter] = -1;
+		}
+		values->push_back(delta[counter]);
+	}
+	bool has_ipc = delta[PERF_CYCLES] > 0 && delta[PERF_INSTRUCTIONS] >= 0;
+	values->push_back(has_ipc ? delta[PERF_INSTRUCTIONS] / delta[PERF_CYCLES] : -1);
+}
+
+void PerfCounters::add_columns(Stats* stats){
+	vector<string> columns;
+	names(&columns);
+	open();
+	stats->add_columns(columns, [this](vector<double>* values) {
+		read_delta(values);
+	});
+}
@@ -0,0 +1,56 @@
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#include "Stats.h"
+
+#include <vector>
+#include <string>
+
+using namespace std;
+
+enum PerfCounter {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_LLC_MISSES, // last level cache misses
+	PERF_BRANCH_MISSES,
+	PERF_DTLB_MISSES, // data TLB read misses
+	NUM_PERF_COUNTERS
+};
+
+// Hardware counters of the process read with Linux perf_event_open, user
+// space only and including the threads started after the counters are
+// opened (the instances of the ensembles). Each counter is opened on its
+// own: the ones not available (no PMU in a VM, perf_event_paranoid too high,
+// not Linux) read as -1 and the others are still counted. The counts are
+// scaled when the kernel multiplexes the counters.
+class PerfCounters {
+public:
+	PerfCounters();
+	virtual ~PerfCounters();
+
+	// Opens and starts the counters, returns the number available. Prints a
+	// warning to cerr if some are not.
+	int open();
+
+	bool available(int counter) const {
+		return fds_[counter] >= 0;
+	}
+
+	// Counts since the previous call (or open()), one per counter, then the
+	// instructions per cycle; -1 for the counters not available.
+	void read_delta(vector<double>* values);
+
+	// Names of the values of read_delta.
+	static void names(vector<string>* names);
+
+	// Adds the counts of each stats window as columns (opens the counters).
+	void add_columns(Stats* stats);
+
+private:
+	bool read_counter(int counter, double* value) const;
+
+	int fds_[NUM_PERF_COUNTERS];
+	double last_[NUM_PERF_COUNTERS];
+};
+
+#endif /* PERFCOUNTERS_H_ */
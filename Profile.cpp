@@ -0,0 +1,39 @@
+#include "Profile.h"
+#include <cstring>
+
+using namespace std;
+
+#ifdef TRIEST_PROFILE
+
+thread_local ProfileState profile_state = {{0}, {0}, PHASE_OTHER, 0};
+
+void add_profile_columns(Stats* stats){
+	const char* phases[NUM_PHASES] = {"parse_us", "sampling_us", "adjacency_us", "probe_us", "estimate_us", "other_us"};
+	const char* events[NUM_EVENTS] = {"neighbors_scanned", "edge_probes", "evictions", "triangles_found"};
+	vector<string> columns(phases, phases + NUM_PHASES);
+	columns.insert(columns.end(), events, events + NUM_EVENTS);
+
+	// The run starts now
+	profile_switch(PHASE_OTHER);
+	memset(profile_state.nanos, 0, sizeof(profile_state.nanos));
+	memset(profile_state.events, 0, sizeof(profile_state.events));
+
+	stats->add_columns(columns, [](vector<double>* values) {
+		profile_switch(profile_state.phase); // time of the current phase up to now
+		for (int phase = 0; phase < NUM_PHASES; phase++){
+			values->push_back(profile_state.nanos[phase] / 1000.0);
+		}
+		for (int event = 0; event < NUM_EVENTS; event++){
+			values->push_back(profile_state.events[event]);
+		}
+		memset(profile_state.nanos, 0, sizeof(profile_state.nanos));
+		memset(profile_state.events, 0, sizeof(profile_state.events));
+	});
+}
+
+#else
+
+void add_profile_columns(Stats*){
+}
+
+#endif /* TRIEST_PROFILE */
@@ -0,0 +1,85 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include "Stats.h"
+
+#include <chrono>
+
+using namespace std;
+
+// Instrumentation of the phases of the updates, compiled only with
+// -DTRIEST_PROFILE (make PROFILE=-DTRIEST_PROFILE). Otherwise the macros
+// below are empty and add_profile_columns() adds no column.
+//
+// PROFILE_PHASE(phase) attributes the time until the end of the enclosing
+// block to phase; the time of the nested phases is not counted in the outer
+// one. PROFILE_COUNT(event, n) adds n occurrences of event. Counts and times
+// are per thread: the reported ones are those of the thread running the
+// stats (the first instance in multi-instance runs).
+
+enum ProfilePhase {
+	PHASE_PARSE, // reading the graph updates
+	PHASE_SAMPLING, // sampling decisions (exec_operation of the sampler)
+	PHASE_ADJACENCY, // UDynGraph edge additions and removals
+	PHASE_PROBE, // triangle probes of TriangleCounter
+	PHASE_ESTIMATE, // estimates at the end of the windows
+	PHASE_OTHER, // anything else (the main loop, stats)
+	NUM_PHASES
+};
+
+enum ProfileEvent {
+	EVENT_NEIGHBORS_SCANNED,
+	EVENT_EDGE_PROBES, // lookups in the edge index of TriangleCounter
+	EVENT_EVICTIONS, // sampled edges replaced by new ones
+	EVENT_TRIANGLES_FOUND,
+	NUM_EVENTS
+};
+
+// Adds the per window columns (microseconds of each phase and event counts).
+void add_profile_columns(Stats* stats);
+
+#ifdef TRIEST_PROFILE
+
+typedef struct ProfileState {
+	unsigned long long nanos[NUM_PHASES];
+	unsigned long long events[NUM_EVENTS];
+	int phase; // current phase
+	long long since; // steady clock (ns) when the current phase was entered
+} ProfileState;
+
+extern thread_local ProfileState profile_state;
+
+inline void profile_switch(int phase){
+	long long now = chrono::duration_cast<chrono::nanoseconds>(
+			chrono::steady_clock::now().time_since_epoch()).count();
+	profile_state.nanos[profile_state.phase] += now - profile_state.since;
+	profile_state.since = now;
+	profile_state.phase = phase;
+}
+
+class ProfileScope {
+public:
+	explicit ProfileScope(int phase) : previous_(profile_state.phase) {
+		profile_switch(phase);
+	}
+	~ProfileScope() {
+		profile_switch(previous_);
+	}
+
+private:
+	int previous_;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_PHASE(phase) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(phase)
+#define PROFILE_COUNT(event, n) (profile_state.events[event] += (n))
+
+#else
+
+#define PROFILE_PHASE(phase)
+#define PROFILE_COUNT(event, n)
+
+#endif /* TRIEST_PROFILE */
+
+#endif /* PROFILE_H_ */
@@ -3,21 +3,139 @@
 #include "TriangleCounter.h"
 #include "UDynGraph.h"
 #include "Stats.h"
+#include "StatsSinks.h"
+#include "SamplerEnsemble.h"
+#include "PartitionedSampler.h"
+#include "Snapshot.h"
+#include "Summary.h"
+#include "SamplerDriver.h"
+#include "LatencyHistogram.h"
+#include "Profile.h"
+#include "PerfCounters.h"
+#include "GroundTruth.h"
 
 #include <iostream>
 #include <cassert>
 #include <cstring>
+#include <string>
+#include <csignal>
+#include <functional>
+#include <chrono>
 
 using namespace std;
 
+#define SNAPSHOT_MAGIC "TRIEST-SNAPSHOT-1"
+
+static volatile sig_atomic_t checkpoint_requested = 0;
+
+static void request_checkpoint(int) {
+	checkpoint_requested = 1;
+}
+
+// Loop over the updates executed by a single sampler, instantiated for each
+// sampler type (see SamplerDriver.h).
+struct UpdateLoop {
+	GraphScheduler* scheduler;
+	TriangleCounter* counter;
+	Stats* stats;
+	bool only_add;
+	unsigned long long* count_op;
+	unsigned long long* offset; // in the file after the last update executed
+	bool checkpoints;
+	unsigned long long checkpoint_every;
+	function<void()> checkpoint;
+	UpdateLatencies* latencies; // NULL if not measured
+
+	template <class Sampler>
+	void run(Sampler* sampler) {
+		while (scheduler->has_next()) {
+			EdgeUpdate update = scheduler->next_update();
+			if(only_add && !update.is_add){
+				break; // ENDS at the first remove
+			}
+
+			if (latencies) {
+				// The update touches the sample if it adds or removes sample edges
+				unsigned long long sample_changes = counter->sample_changes();
+				auto begin = chrono::steady_clock::now();
+				exec_operation(sampler, update);
+				auto end = chrono::steady_clock::now();
+				latencies->record(update.is_add, counter->sample_changes() != sample_changes,
+						chrono::duration_cast<chrono::nanoseconds>(end - begin).count());
+			} else {
+				exec_operation(sampler, update);
+			}
+
+			// This is the crude number of triangles in the sample (not the unbiased est.) Use Sampler->get_triangles_est() for the unbiased estimator.
+			unsigned long long int triangles = sample_triangles(sampler, counter);
+
+			stats->exec_op(update.is_add, triangles,
+				sample_size(sampler, counter), update.time);
+
+			++*count_op;
+			*offset = scheduler->offset();
+			if (checkpoints && (checkpoint_requested
+					|| (checkpoint_every > 0 && *count_op % checkpoint_every == 0))) {
+				checkpoint_requested = 0;
+				checkpoint();
+			}
+		}
+	}
+};
+
 int main(int argc, char** argv) {
 
-	if (argc <= 6) {
+	// Named options, removed from the positional parameters
+	string checkpoint_file;
+	unsigned long long checkpoint_every = 0;
+	string restore_file;
+	string summary_file;
+	string stats_binary_file;
+	bool stats_async = false;
+	string latency_file;
+	bool perf = false;
+	bool memory = false;
+	string truth_file;
+	int num_positional = 1;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--checkpoint") == 0 && i+1 < argc) {
+			checkpoint_file = argv[++i];
+		} else if (strcmp(argv[i], "--checkpoint-every") == 0 && i+1 < argc) {
+			checkpoint_every = atoll(argv[++i]);
+		} else if (strcmp(argv[i], "--restore") == 0 && i+1 < argc) {
+			restore_file = argv[++i];
+		} else if (strcmp(argv[i], "--summary") == 0 && i+1 < argc) {
+			summary_file = argv[++i];
+		} else if (strcmp(argv[i], "--stats-binary") == 0 && i+1 < argc) {
+			stats_binary_file = argv[++i];
+		} else if (strcmp(argv[i], "--latency") == 0 && i+1 < argc) {
+			latency_file = argv[++i];
+		} else if (strcmp(argv[i], "--stats-async") == 0) {
+			stats_async = true;
+		} else if (strcmp(argv[i], "--perf") == 0) {
+			perf = true;
+		} else if (strcmp(argv[i], "--memory") == 0) {
+			memory = true;
+		} else if (strcmp(argv[i], "--truth") == 0 && i+1 < argc) {
+			truth_file = argv[++i];
+		} else {
+			argv[num_positional++] = argv[i];
+		}
+	}
+	argc = num_positional;
+
+	if (argc <= 5 || (argc <= 6 && strcmp(argv[5], "X") != 0)) {
 		cerr
 				<< "ERROR Requires FIRST 5 parameters. RunCounting only_add (1=yes,0=no); random_seed (int); stats_every_num_updates (int); graph-udates.txt;\n" <<
-				"THEN: Type of Sampler (R for reservoir, F for fix-p, RH resevoir sample and hold, FH fix-p sample and hold, P for pinar algo or V for paVan algorithm)"<<
-				" THEN IF reservoir: size reservoir (int) "<<
-				" ELSE IF fixed-p: p (double) "<< endl;
+				"THEN: Type of Sampler (R for reservoir, F for fix-p, RH resevoir sample and hold, FH fix-p sample and hold, P for pinar algo, V for paVan algorithm, W for reservoir on a sliding time window or T for thinkd or WR for waiting room sampling or H for coordinated reservoir, by edge hash or X for the exact count, no sampling)"<<
+				" THEN IF reservoir: size reservoir (int) or memory budget (e.g. 512K, 64M, 2G bytes)"<<
+				" ELSE IF exact: nothing"<<
+				" ELSE IF coordinated reservoir: size reservoir (int), the edge hash depends only on the random seed"<<
+				" ELSE IF waiting room: size memory[,fraction of waiting room] (int[,double], default fraction 0.1) "<<
+				" ELSE IF sliding window: size reservoir,window length (int,int e.g. 10000,86400 in the time units of the graph) "<<
+				" ELSE IF fixed-p: p (double) "<<
+				" OPTIONALLY: K (int, default 1) for an ensemble of K independent instances averaged, EK to partition the edges among K workers by hashing, CK to partition them by vertex colour, the memory is split among the K instances\n"<<
+				"OPTIONS: --checkpoint file (written at the end, every --checkpoint-every updates and on SIGUSR1); --restore file (continues the run saved in the file); --summary file (mergeable summary written at the end, R and H only, see MergeSummaries); --stats-binary file (stats written to file in binary instead of tsv to stdout); --stats-async (stats written by another thread); --latency file (latency percentiles of the updates in the stats, histograms of the run written to file); --perf (hardware counters of each window in the stats: cycles, instructions, LLC, branch and dTLB misses, instructions per cycle, -1 if not available); --memory (estimated heap bytes of the reservoir, edge index, graph, local counts and edge weights in the stats, with the total and the bytes per sampled edge); --truth file (exact count and relative error of the estimate in the stats, from the file written by ExactCounting with the same only_add)"<< endl;
 		exit(1);
 	}
 
@@ -34,67 +152,313 @@ int main(int argc, char** argv) {
 	bool is_reservoir = strcmp(argv[5], "R") == 0 || strcmp(argv[5], "RH") == 0;
 	bool is_fix_p  = strcmp(argv[5], "F") == 0 || strcmp(argv[5], "FH") == 0;
 	bool use_sample_and_hold = strcmp(argv[5], "RH") == 0 || strcmp(argv[5], "FH") == 0;
+	bool is_thinkd = strcmp(argv[5], "T") == 0;
+	bool is_waiting_room = strcmp(argv[5], "WR") == 0;
 	bool is_pinar = strcmp(argv[5], "P") == 0;
 	bool is_pavan = strcmp(argv[5], "V") == 0;
+	bool is_window = strcmp(argv[5], "W") == 0;
+	bool is_coordinated = strcmp(argv[5], "H") == 0;
+	bool is_exact = strcmp(argv[5], "X") == 0;
 
 	assert(only_add || !use_sample_and_hold); //can't use sample and hold with deletion
 
 	double p = -1;
 	int size_reservoir = -1;
-	if (is_reservoir){
+	int window_length = -1;
+	double waiting_room_fraction = 0.1;
+	size_t memory_budget = 0; // bytes, if the reservoir is given as a memory budget
+	if (is_reservoir || is_thinkd){
+		size_reservoir = atoi(argv[6]);
+		char unit = argv[6][strlen(argv[6])-1];
+		if (is_reservoir && (unit == 'K' || unit == 'M' || unit == 'G')){
+			memory_budget = (size_t)(atof(argv[6]) * (unit == 'K' ? 1<<10 : (unit == 'M' ? 1<<20 : 1<<30)));
+		}
+	} else if (is_waiting_room){
 		size_reservoir = atoi(argv[6]);
+		const char* fraction = strchr(argv[6], ',');
+		if (fraction != NULL){
+			waiting_room_fraction = atof(fraction+1);
+		}
 	} else if (is_fix_p){
 		p = atof(argv[6]);
-	} else if (is_pinar){
+	} else if (is_pinar || is_coordinated){
 		size_reservoir = atoi(argv[6]);
 	} else if (is_pavan){
 		size_reservoir = atoi(argv[6]);
+	} else if (is_exact){
+		// no parameter
+	} else if (is_window){
+		size_reservoir = atoi(argv[6]);
+		const char* window = strchr(argv[6], ',');
+		assert(window != NULL);
+		window_length = atoi(window+1);
+		assert(window_length > 0);
 	} else{
 		cerr<<argv[5]<<" not supported yet."<<endl;
 		assert(false);
 	}
 
-  GraphScheduler scheduler(file_name, false /* not storing time*/);
+	int num_instances = 1;
+	bool is_partitioned = false;
+	Partitioning partitioning = EDGE_HASH;
+	if (argc > 7){
+		if (argv[7][0] == 'E' || argv[7][0] == 'C'){
+			is_partitioned = true;
+			partitioning = argv[7][0] == 'E' ? EDGE_HASH : VERTEX_COLOR;
+			num_instances = atoi(argv[7]+1);
+		} else {
+			num_instances = atoi(argv[7]);
+		}
+	}
+	assert(num_instances > 0);
+	// Same total memory for the ensemble / partition
+	if (is_fix_p){
+		p /= num_instances;
+	} else {
+		size_reservoir /= num_instances;
+	}
+	memory_budget /= num_instances;
+
+	// Position of the run to restore
+	SnapshotReader snapshot;
+	unsigned long long count_op = 0;
+	unsigned long long start_offset = 0;
+	if (!restore_file.empty()) {
+		string magic, sampler_type;
+		if (!snapshot.open(restore_file) || !snapshot.get_string(&magic) || magic != SNAPSHOT_MAGIC
+				|| !snapshot.get_string(&sampler_type) || sampler_type != argv[5]
+				|| !snapshot.get(&count_op) || !snapshot.get(&start_offset)) {
+			cerr << "ERROR " << restore_file << " is not a snapshot of a " << argv[5] << " sampler." << endl;
+			exit(1);
+		}
+	}
+
+  GraphScheduler scheduler(file_name, is_window /* time needed only by the sliding window*/, start_offset);
   TriangleCounter counter(false /*no local count*/);
-	GraphSampler* sampler;
 
-	if(is_reservoir && only_add) {
-		sampler = new ReservoirSampler(size_reservoir, use_sample_and_hold, &counter);
-	} else if(is_reservoir && !only_add) {
-		sampler = new ReservoirAddRemSampler(size_reservoir, &counter);
-	} else if(is_fix_p) {
-		sampler = new FixedPSampler(p, use_sample_and_hold, &counter);
-	} else if (is_pinar){
-		sampler = new PinarSampler(size_reservoir, size_reservoir); // USE SAME SIZE FOR BOTH RESERVOIR
-	} else if (is_pavan){
-		sampler = new PavanSampler(size_reservoir); 
-	} else {
+	SamplerFactory make_sampler = [&](TriangleCounter* counter) -> GraphSampler* {
+		if(is_reservoir && only_add) {
+			ReservoirSampler* reservoir = new ReservoirSampler(size_reservoir, use_sample_and_hold, counter);
+			if (memory_budget > 0){
+				reservoir->set_memory_budget(memory_budget);
+			}
+			return reservoir;
+		} else if(is_reservoir && !only_add) {
+			ReservoirAddRemSampler* reservoir = new ReservoirAddRemSampler(size_reservoir, counter);
+			if (memory_budget > 0){
+				reservoir->set_memory_budget(memory_budget);
+			}
+			return reservoir;
+		} else if(is_fix_p) {
+			return new FixedPSampler(p, use_sample_and_hold, counter);
+		} else if (is_thinkd){
+			return new ThinkDSampler(size_reservoir, counter);
+		} else if (is_waiting_room){
+			return new WaitingRoomSampler(size_reservoir, waiting_room_fraction, counter);
+		} else if (is_pinar){
+			return new PinarSampler(size_reservoir, size_reservoir); // USE SAME SIZE FOR BOTH RESERVOIR
+		} else if (is_pavan){
+			return new PavanSampler(size_reservoir);
+		} else if (is_window){
+			return new SlidingWindowSampler(size_reservoir, window_length, counter);
+		} else if (is_coordinated){
+			return new CoordinatedSampler(size_reservoir, random_seed, counter);
+		} else if (is_exact){
+			return new ExactSampler(false /*no local count*/);
+		}
 		assert(false);
+		return NULL;
+	};
+
+	GraphSampler* sampler;
+	MultiSampler* multi = NULL; // set if the updates are executed by multiple samplers in parallel
+	SamplerEnsemble* ensemble = NULL;
+	if (is_partitioned){
+		multi = new PartitionedSampler(num_instances, partitioning, false /*no local count*/, make_sampler);
+		sampler = multi;
+	} else if (num_instances == 1){
+		sampler = make_sampler(&counter);
+	} else {
+		ensemble = new SamplerEnsemble(num_instances, false /*no local count*/, make_sampler);
+		multi = ensemble;
+		sampler = ensemble;
+	}
+
+	if ((!checkpoint_file.empty() || !restore_file.empty() || !summary_file.empty() || !latency_file.empty()) && multi) {
+		cerr << "ERROR checkpoints, summaries and latencies are not supported with multiple instances." << endl;
+		exit(1);
+	}
+	if (is_exact && num_instances > 1) {
+		cerr << "ERROR the exact counter runs as a single instance." << endl;
+		exit(1);
+	}
+	if (!restore_file.empty() && !sampler->load(&snapshot)) {
+		cerr << "ERROR cannot restore the sampler from " << restore_file << endl;
+		exit(1);
+	}
+	// Resumed runs restart from offset: the updates read by the scheduler but
+	// not executed (the remove that ends an only_add run) are read again.
+	unsigned long long offset = start_offset;
+	auto checkpoint = [&]() {
+		SnapshotWriter out;
+		out.put_string(SNAPSHOT_MAGIC);
+		out.put_string(argv[5]);
+		out.put(count_op);
+		out.put(offset);
+		if (!sampler->save(&out)) {
+			cerr << "ERROR checkpoints are not supported by the " << argv[5] << " sampler." << endl;
+			exit(1);
+		}
+		if (!out.write(checkpoint_file)) {
+			cerr << "ERROR cannot write " << checkpoint_file << endl;
+		}
+	};
+	if (!checkpoint_file.empty()) {
+		signal(SIGUSR1, request_checkpoint);
 	}
 
 	Stats stats(stats_freq);
+	StatsSink* sink = NULL;
+	if (!stats_binary_file.empty()) {
+		BinaryStatsSink* binary_sink = new BinaryStatsSink(stats_binary_file);
+		if (!binary_sink->ok()) {
+			cerr << "ERROR cannot write " << stats_binary_file << endl;
+			exit(1);
+		}
+		sink = binary_sink;
+	}
+	if (stats_async) {
+		sink = new AsyncStatsSink(sink ? sink : new TsvStatsSink(&cout));
+	}
+	if (sink) {
+		stats.set_sink(sink);
+	}
+	stats.resume(count_op);
+	// The estimate is only needed at the end of each stats window.
+	stats.set_estimate_callback([sampler]() { return sampler->get_triangle_est(); });
 
-	while (scheduler.has_next()) {
-		EdgeUpdate update = scheduler.next_update();
-		if(only_add && !update.is_add){
-			break; // ENDS at the first remove
+	UpdateLatencies latencies;
+	if (!latency_file.empty()) {
+		latencies.add_columns(&stats);
+	}
+	// Phase times and event counts, only when built with -DTRIEST_PROFILE
+	add_profile_columns(&stats);
+	PerfCounters perf_counters;
+	if (perf) {
+		perf_counters.add_columns(&stats);
+	}
+	GroundTruthReader truth;
+	if (!truth_file.empty()) {
+		if (!truth.open(truth_file)) {
+			cerr << "ERROR " << truth_file << " is not a ground truth file." << endl;
+			exit(1);
+		}
+		vector<string> columns = {"exact_triangles", "est_rel_error"};
+		Stats* stats_ptr = &stats;
+		GroundTruthReader* truth_ptr = &truth;
+		stats.add_columns(columns, [stats_ptr, truth_ptr](vector<double>* values) {
+			GroundTruthRecord record;
+			if (!truth_ptr->seek(stats_ptr->op_count(), &record)) {
+				cerr << "ERROR no ground truth after " << stats_ptr->op_count() << " updates." << endl;
+				exit(1);
+			}
+			values->push_back(record.triangles);
+			values->push_back(record.triangles > 0 ? (stats_ptr->last_estimate() - record.triangles) / record.triangles : 0);
+		});
+	}
+	if (memory) {
+		vector<string> columns;
+		for (int structure = 0; structure < NUM_MEMORY_STRUCTURES; structure++){
+			columns.push_back(string("mem_") + MemoryUsage::name(structure));
 		}
+		columns.push_back("mem_total");
+		columns.push_back("bytes_per_sampled_edge");
+		TriangleCounter* counter_ptr = &counter;
+		ExactSampler* exact = dynamic_cast<ExactSampler*>(sampler);
+		stats.add_columns(columns, [sampler, multi, exact, counter_ptr](vector<double>* values) {
+			MemoryUsage usage;
+			sampler->memory_usage(&usage);
+			values->insert(values->end(), usage.bytes, usage.bytes + NUM_MEMORY_STRUCTURES);
+			values->push_back(usage.total());
+			int sampled = multi ? multi->size_sample() : (exact ? exact->num_edges() : counter_ptr->size_sample());
+			values->push_back(sampled > 0 ? (double)usage.total() / sampled : 0);
+		});
+	}
 
-		sampler->exec_operation(update);
+	if (ensemble){
+		vector<string> columns;
+		columns.push_back("est_variance");
+		for (int i = 0; i < num_instances; i++){
+			columns.push_back("est_" + to_string(i));
+		}
+		stats.add_columns(columns, [ensemble](vector<double>* values) {
+			vector<double> estimates;
+			ensemble->instance_estimates(&estimates);
+			double mean = 0;
+			for (const auto& est: estimates){
+				mean += est;
+			}
+			mean /= estimates.size();
+			double variance = 0;
+			for (const auto& est: estimates){
+				variance += (est-mean)*(est-mean);
+			}
+			values->push_back(variance/(estimates.size()-1));
+			values->insert(values->end(), estimates.begin(), estimates.end());
+		});
+	}
 
-		//cout << "OP: "<<update.is_add<<" "<<update.node_u<<" "<<update.node_v <<endl;
+	if (!multi){
+		UpdateLoop loop = {&scheduler, &counter, &stats, only_add, &count_op, &offset,
+				!checkpoint_file.empty(), checkpoint_every, checkpoint,
+				latency_file.empty() ? NULL : &latencies};
+		run_with_static_type(sampler, loop);
+		if (!checkpoint_file.empty()) {
+			checkpoint();
+		}
+	} else {
+		// Each batch is executed by the instances in parallel. Batches end at
+		// the stats windows boundaries.
+		vector<EdgeUpdate> batch;
+		bool ended = false;
+		stats.start();
+		while (!ended && scheduler.has_next()) {
+			batch.clear();
+			size_t batch_size = min((unsigned long long)CHUNK_SIZE, stats_freq - count_op % stats_freq);
+			while (batch.size() < batch_size && scheduler.has_next()) {
+				EdgeUpdate update = scheduler.next_update();
+				if(only_add && !update.is_add){
+					ended = true; // ENDS at the first remove
+					break;
+				}
+				batch.push_back(update);
+			}
 
-		// This is the crude number of triangles in the sample (not the unbiased est.) Use Sampler->get_triangles_est() for the unbiased estimator.
-		unsigned long long int triangles = counter.triangles();
-		double triangles_est = sampler->get_triangle_est();
+			multi->exec_batch(batch);
+			count_op += batch.size();
 
-		stats.exec_op(update.is_add, triangles, triangles_est,
-			counter.size_sample(), update.time);
-		//if(++count_op%stats_freq==0){
-		//	cout << count_op << " "<<triangles<< " " <<sampler->get_triangle_est()<<endl;
-		//}
+			unsigned long long int triangles = multi->triangles();
+			int size_sample = multi->size_sample();
+			for (const auto& update: batch){
+				stats.exec_op(update.is_add, triangles, size_sample, update.time);
+			}
+		}
 	}
 	stats.end_op();
+	if (!latency_file.empty() && !latencies.write(latency_file)) {
+		cerr << "ERROR cannot write " << latency_file << endl;
+	}
+
+	if (!summary_file.empty()) {
+		EdgeSummary summary;
+		if (!sampler->summary(&summary)) {
+			cerr << "ERROR summaries are not supported by the " << argv[5] << " sampler." << endl;
+			exit(1);
+		}
+		if (!write_summary_file(summary_file, summary)) {
+			cerr << "ERROR cannot write " << summary_file << endl;
+		}
+	}
 
 	delete sampler;
   return 0;
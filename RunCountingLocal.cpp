@@ -3,11 +3,18 @@
 #include "TriangleCounter.h"
 #include "UDynGraph.h"
 #include "Stats.h"
+#include "SamplerEnsemble.h"
+#include "PartitionedSampler.h"
+#include "SamplerDriver.h"
+#include "PerfCounters.h"
+#include "GroundTruth.h"
 
 #include <iostream>
 #include <cassert>
 #include <cstring>
 #include <cmath>
+#include <thread>
+#include <deque>
 
 using namespace std;
 
@@ -18,62 +25,255 @@ struct Result {
 	double top_triangle_est = 0.0;
 };
 
-Result local_err(TriangleCounter& gt_counter, GraphSampler& gt_sampler, TriangleCounter& est_counter, GraphSampler& est_sampler){
-	Result res;
-	res.top_triangle_exact = 0.0;
-	res.top_triangle_est = 0.0;
-
-	vector<int> nodes;
-	gt_counter.get_nodes(&nodes);
+// Nodes per block of local_err. The blocks, not the threads, fix the order
+// of the floating point reductions.
+#define LOCAL_ERR_BLOCK 1024
 
-	double gt_avg = 0.0;
-	double est_avg = 0.0;
+// Aggregates of the errors over a set of nodes: means and sums of the
+// squared deviations (and co-deviations) of the exact and estimated local
+// counts, updated one node at a time (Welford) and merged pairwise (Chan et
+// al.) so the Pearson correlation is computed in a single pass.
+struct ErrorMoments {
+	double n = 0.0;
+	double mean_gt = 0.0;
+	double mean_est = 0.0;
+	double dev_gt = 0.0;
+	double dev_est = 0.0;
+	double cov = 0.0;
+	double eps_err = 0.0; // sum of |gt - est| / (gt + 1)
+	double top_gt = 0.0;
+	double top_est = 0.0;
 
-	for (const auto & n: nodes){
-		gt_avg+=gt_sampler.get_triangle_est_local(n);
-		est_avg+=est_sampler.get_triangle_est_local(n);
+	void add(double gt, double est) {
+		n += 1;
+		double delta_gt = gt - mean_gt;
+		mean_gt += delta_gt / n;
+		double delta_est = est - mean_est;
+		mean_est += delta_est / n;
+		dev_gt += delta_gt * (gt - mean_gt);
+		dev_est += delta_est * (est - mean_est);
+		cov += delta_gt * (est - mean_est);
+		eps_err += abs(gt - est) / (gt + 1);
+		top_gt = max(top_gt, gt);
+		top_est = max(top_est, est);
 	}
-	gt_avg/=nodes.size();
-	est_avg/=nodes.size();
 
-	double cov = 0.0;
-	double sum_dev_gt = 0.0;
-	double sum_dev_est = 0.0;
-
-	double mean_eps_err = 0.0;
-	for (const auto & n: nodes){
-		double gt_ =gt_sampler.get_triangle_est_local(n);
-		double est_ =est_sampler.get_triangle_est_local(n);
-		if (gt_>res.top_triangle_exact){
-			res.top_triangle_exact = gt_;
+	void merge(const ErrorMoments& other) {
+		if (other.n == 0) {
+			return;
 		}
-		if (est_>res.top_triangle_est){
-			res.top_triangle_est = est_;
+		double total = n + other.n;
+		double delta_gt = other.mean_gt - mean_gt;
+		double delta_est = other.mean_est - mean_est;
+		double weight = n * other.n / total;
+		mean_gt += delta_gt * other.n / total;
+		mean_est += delta_est * other.n / total;
+		dev_gt += other.dev_gt + delta_gt * delta_gt * weight;
+		dev_est += other.dev_est + delta_est * delta_est * weight;
+		cov += other.cov + delta_gt * delta_est * weight;
+		eps_err += other.eps_err;
+		top_gt = max(top_gt, other.top_gt);
+		top_est = max(top_est, other.top_est);
+		n = total;
+	}
+};
+
+// Exact local count of nodes[i], from the exact counter run next to the
+// sampler...
+struct SamplerTruth {
+	ExactSampler* sampler;
+
+	double operator()(size_t, int node) const {
+		return get_triangle_est_local(sampler, node);
+	}
+};
+
+// ... or from a ground truth record (the nodes of the record).
+struct RecordTruth {
+	const GroundTruthRecord* record;
+
+	double operator()(size_t i, int) const {
+		return record->local_triangles[i];
+	}
+};
+
+// Error of the local estimates of est_sampler against the exact ones, in a
+// single pass over the nodes split in blocks among num_threads threads. The
+// local estimates only read the samplers (the probability cached by
+// ReservoirAddRemSampler is computed before the threads start). The blocks
+// are merged in order: the result does not depend on num_threads.
+template <class Truth, class Sampler>
+Result local_err(const vector<int>& nodes, const Truth& truth, Sampler* est_sampler, int num_threads){
+	Result res;
+	if (nodes.empty()){
+		return res;
+	}
+	truth(0, nodes[0]);
+	get_triangle_est_local(est_sampler, nodes[0]);
+
+	size_t num_blocks = (nodes.size() + LOCAL_ERR_BLOCK - 1) / LOCAL_ERR_BLOCK;
+	vector<ErrorMoments> blocks(num_blocks);
+	auto run_blocks = [&](size_t first_block, size_t last_block) {
+		for (size_t block = first_block; block < last_block; block++){
+			size_t end = min(nodes.size(), (block + 1) * LOCAL_ERR_BLOCK);
+			for (size_t i = block * LOCAL_ERR_BLOCK; i < end; i++){
+				blocks[block].add(truth(i, nodes[i]), get_triangle_est_local(est_sampler, nodes[i]));
+			}
 		}
-		mean_eps_err+= abs(gt_-est_)/(gt_+1);
+	};
+	size_t num_workers = min(num_blocks, (size_t)max(num_threads, 1));
+	vector<thread> workers;
+	for (size_t w = 1; w < num_workers; w++){
+		workers.push_back(thread(run_blocks, w * num_blocks / num_workers, (w + 1) * num_blocks / num_workers));
+	}
+	run_blocks(0, num_blocks / num_workers);
+	for (auto& worker: workers){
+		worker.join();
+	}
 
-		cov += (gt_-gt_avg)*(est_-est_avg);
-		sum_dev_gt += (gt_-gt_avg)*(gt_-gt_avg);
-		sum_dev_est += (est_-est_avg)*(est_-est_avg);
+	ErrorMoments all;
+	for (const auto& block: blocks){
+		all.merge(block);
 	}
-	if(sum_dev_est==0){
+	res.top_triangle_exact = all.top_gt;
+	res.top_triangle_est = all.top_est;
+	if(all.dev_est==0){
 		res.pearson =0;//In this case it is not well defined
 	} else {
-		res.pearson = cov/(sqrt(sum_dev_gt)*sqrt(sum_dev_est));
+		res.pearson = all.cov/(sqrt(all.dev_gt)*sqrt(all.dev_est));
 	}
-	res.mean_eps_err = mean_eps_err/nodes.size();
+	res.mean_eps_err = all.eps_err/all.n;
 	return res;
 }
 
 
+// Edges in the sample (summed over the instances when there are many)
+int size_sample(GraphSampler* sampler, const TriangleCounter& counter){
+	MultiSampler* multi = dynamic_cast<MultiSampler*>(sampler);
+	return multi ? multi->size_sample() : counter.size_sample();
+}
+
+// Loop over the updates, instantiated for each sampler type (see
+// SamplerDriver.h). Updates are executed in batches ending at the error checks.
+struct UpdateLoop {
+	GraphScheduler* scheduler;
+	TriangleCounter* counter;
+	ExactSampler* sampler_exact;
+	bool only_add;
+	int stats_freq;
+	PerfCounters* perf_counters; // NULL if not measured
+	int num_threads; // of the error checks
+	GroundTruthReader* truth; // if not NULL, replaces the exact sampler
+	int window_length; // if > 0, the exact counts are of the last window_length time units
+
+	template <class Sampler>
+	void run(Sampler* sampler) {
+		unsigned long long count_op = 0;
+		vector<EdgeUpdate> batch;
+		vector<EdgeUpdate> exact_batch; // batch and expirations of the window
+		deque<EdgeUpdate> window; // edges in the window of the exact sampler
+		bool ended = false;
+		while (!ended && scheduler->has_next()) {
+			batch.clear();
+			size_t batch_size = min((unsigned long long)CHUNK_SIZE, stats_freq - count_op % stats_freq);
+			while (batch.size() < batch_size && scheduler->has_next()) {
+				EdgeUpdate update = scheduler->next_update();
+				if(only_add && !update.is_add){
+					ended = true; // ENDS at the first remove
+					break;
+				}
+				batch.push_back(update);
+			}
+
+			exec_batch(sampler, batch);
+
+			if (!truth && window_length > 0) {
+				// The edges leaving the window are deleted from the exact
+				// sampler when the sliding window sampler expires them.
+				exact_batch.clear();
+				for (const auto& update: batch) {
+					while (!window.empty() && window.front().time <= update.time - window_length) {
+						exact_batch.push_back(window.front());
+						exact_batch.back().is_add = false;
+						window.pop_front();
+					}
+					exact_batch.push_back(update);
+					window.push_back(update);
+				}
+				exec_batch(sampler_exact, exact_batch);
+			} else if (!truth) {
+				exec_batch(sampler_exact, batch);
+			}
+
+			count_op += batch.size();
+			if(count_op%stats_freq==0){
+				unsigned long long triangles_exact;
+				GroundTruthRecord record;
+				if (truth) {
+					if (!truth->seek(count_op, &record) || record.nodes.empty()) {
+						cerr << "ERROR no local ground truth after " << count_op << " updates." << endl;
+						exit(1);
+					}
+					triangles_exact = record.triangles;
+				} else {
+					triangles_exact = sampler_exact->triangles();
+				}
+				if(triangles_exact == 0){
+					continue; // No error possibile !
+				}
+				Result res;
+				if (truth) {
+					RecordTruth exact = {&record};
+					res = local_err(record.nodes, exact, sampler, num_threads);
+				} else {
+					SamplerTruth exact = {sampler_exact};
+					res = local_err(sampler_exact->nodes(), exact, sampler, num_threads);
+				}
+				cout << count_op << "\t"<<size_sample(sampler, *counter)<<"\t"<<triangles_exact<< "\t" <<res.top_triangle_exact<<"\t"<<res.top_triangle_est<<"\t" <<res.pearson<<"\t"<<res.mean_eps_err;
+				if (perf_counters) {
+					// Counts since the previous line
+					vector<double> counts;
+					perf_counters->read_delta(&counts);
+					for (const auto& count: counts){
+						cout << "\t" << count;
+					}
+				}
+				cout << endl;
+			}
+		}
+	}
+};
+
 int main(int argc, char** argv) {
 
+	// Named options, removed from the positional parameters
+	bool perf = false;
+	int num_threads = max(1u, thread::hardware_concurrency());
+	string truth_file;
+	int num_positional = 1;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--perf") == 0) {
+			perf = true;
+		} else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+			num_threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--truth") == 0 && i+1 < argc) {
+			truth_file = argv[++i];
+		} else {
+			argv[num_positional++] = argv[i];
+		}
+	}
+	argc = num_positional;
+
 	if (argc <= 6) {
 		cerr
 				<< "ERROR Requires FIRST 5 parameters. RunCounting only_add (1=yes,0=no); random_seed (int); Check_Error_every_number_steps (int); graph-udates.txt;\n" <<
-				"THEN: Type of Sampler (R for reservoir, F for fix-p, RH resevoir sample and hold, FH fix-p sample and hold)"<<
-				" THEN IF reservoir: size reservoir (int) "<<
-				" ELSE IF fixed-p: p (double) "<< endl;
+				"THEN: Type of Sampler (R for reservoir, F for fix-p, RH resevoir sample and hold, FH fix-p sample and hold, T for thinkd or WR for waiting room sampling or W for reservoir on a sliding time window)"<<
+				" THEN IF reservoir: size reservoir (int) or memory budget (e.g. 512K, 64M, 2G bytes)"<<
+				" ELSE IF waiting room: size memory[,fraction of waiting room] (int[,double], default fraction 0.1) "<<
+				" ELSE IF sliding window: size reservoir,window length (int,int e.g. 10000,86400 in the time units of the graph, only_add must be 1, the exact counts are of the window) "<<
+				" ELSE IF fixed-p: p (double) "<<
+				" OPTIONALLY: K (int, default 1) for an ensemble of K independent instances averaged, EK to partition the edges among K workers by hashing, CK to partition them by vertex colour, the memory is split among the K instances\n"<<
+				"OPTIONS: --perf (hardware counters since the previous line appended to each line: cycles, instructions, LLC, branch and dTLB misses, instructions per cycle, -1 if not available); --threads N (threads of the error checks, default the number of cores, the results do not depend on it); --truth file (exact counts written by ExactCounting with the same only_add, instead of counting them during the run, not with W)"<< endl;
 		exit(1);
 	}
 
@@ -90,60 +290,120 @@ int main(int argc, char** argv) {
 	bool is_reservoir = strcmp(argv[5], "R") == 0 || strcmp(argv[5], "RH") == 0;
 	bool is_fix_p  = strcmp(argv[5], "F") == 0 || strcmp(argv[5], "FH") == 0;
 	bool use_sample_and_hold = strcmp(argv[5], "RH") == 0 || strcmp(argv[5], "FH") == 0;
+	bool is_thinkd = strcmp(argv[5], "T") == 0;
+	bool is_waiting_room = strcmp(argv[5], "WR") == 0;
+	bool is_window = strcmp(argv[5], "W") == 0;
 
 	assert(only_add || !use_sample_and_hold); //can't use sample and hold with deletion
+	assert(only_add || !is_window); //the deletions are the expirations of the window
 
 	double p = -1;
 	int size_reservoir = -1;
-	if (is_reservoir){
+	int window_length = -1;
+	double waiting_room_fraction = 0.1;
+	size_t memory_budget = 0; // bytes, if the reservoir is given as a memory budget
+	if (is_reservoir || is_thinkd){
 		size_reservoir = atoi(argv[6]);
+		char unit = argv[6][strlen(argv[6])-1];
+		if (is_reservoir && (unit == 'K' || unit == 'M' || unit == 'G')){
+			memory_budget = (size_t)(atof(argv[6]) * (unit == 'K' ? 1<<10 : (unit == 'M' ? 1<<20 : 1<<30)));
+		}
+	} else if (is_waiting_room){
+		size_reservoir = atoi(argv[6]);
+		const char* fraction = strchr(argv[6], ',');
+		if (fraction != NULL){
+			waiting_room_fraction = atof(fraction+1);
+		}
 	} else if (is_fix_p){
 		p = atof(argv[6]);
+	} else if (is_window){
+		size_reservoir = atoi(argv[6]);
+		const char* window = strchr(argv[6], ',');
+		assert(window != NULL);
+		window_length = atoi(window+1);
+		assert(window_length > 0);
 	} else {
 		cerr<<argv[5]<<" not supported yet."<<endl;
 		assert(false);
 	}
 
-  GraphScheduler scheduler(file_name, false /* not storing time*/);
-  TriangleCounter counter(true /*use local count*/);
-	TriangleCounter counter_exact(true /*use local count*/);
-	FixedPSampler sampler_exact(1.0, false, &counter_exact);
-
-	GraphSampler* sampler;
-
-	if(is_reservoir && only_add) {
-		sampler = new ReservoirSampler(size_reservoir, use_sample_and_hold, &counter);
-	} else if(is_reservoir && !only_add) {
-		sampler = new ReservoirAddRemSampler(size_reservoir, &counter);
-	} else if(is_fix_p) {
-		sampler = new FixedPSampler(p, use_sample_and_hold, &counter);
-	} else{
-		assert(false);
+	int num_instances = 1;
+	bool is_partitioned = false;
+	Partitioning partitioning = EDGE_HASH;
+	if (argc > 7){
+		if (argv[7][0] == 'E' || argv[7][0] == 'C'){
+			is_partitioned = true;
+			partitioning = argv[7][0] == 'E' ? EDGE_HASH : VERTEX_COLOR;
+			num_instances = atoi(argv[7]+1);
+		} else {
+			num_instances = atoi(argv[7]);
+		}
 	}
+	assert(num_instances > 0);
+	// Same total memory for the ensemble / partition
+	if (is_fix_p){
+		p /= num_instances;
+	} else {
+		size_reservoir /= num_instances;
+	}
+	memory_budget /= num_instances;
 
-//	Statsstats(stats_freq);
-	unsigned long long count_op = 0;
-
+  GraphScheduler scheduler(file_name, is_window /* time needed only by the sliding window*/);
+  TriangleCounter counter(true /*use local count*/);
+	ExactSampler sampler_exact(true /*use local count*/);
 
-	while (scheduler.has_next()) {
-		EdgeUpdate update = scheduler.next_update();
-		if(only_add && !update.is_add){
-			break; // ENDS at the first remove
+	SamplerFactory make_sampler = [&](TriangleCounter* counter) -> GraphSampler* {
+		if(is_reservoir && only_add) {
+			ReservoirSampler* reservoir = new ReservoirSampler(size_reservoir, use_sample_and_hold, counter);
+			if (memory_budget > 0){
+				reservoir->set_memory_budget(memory_budget);
+			}
+			return reservoir;
+		} else if(is_reservoir && !only_add) {
+			ReservoirAddRemSampler* reservoir = new ReservoirAddRemSampler(size_reservoir, counter);
+			if (memory_budget > 0){
+				reservoir->set_memory_budget(memory_budget);
+			}
+			return reservoir;
+		} else if(is_fix_p) {
+			return new FixedPSampler(p, use_sample_and_hold, counter);
+		} else if (is_thinkd){
+			return new ThinkDSampler(size_reservoir, counter);
+		} else if (is_waiting_room){
+			return new WaitingRoomSampler(size_reservoir, waiting_room_fraction, counter);
+		} else if (is_window){
+			return new SlidingWindowSampler(size_reservoir, window_length, counter);
 		}
+		assert(false);
+		return NULL;
+	};
 
-		sampler->exec_operation(update);
-
-		sampler_exact.exec_operation(update);
+	GraphSampler* sampler;
+	if (is_partitioned){
+		sampler = new PartitionedSampler(num_instances, partitioning, true /*use local count*/, make_sampler);
+	} else if (num_instances == 1){
+		sampler = make_sampler(&counter);
+	} else {
+		sampler = new SamplerEnsemble(num_instances, true /*use local count*/, make_sampler);
+	}
 
-		unsigned long long  triangles_exact = counter_exact.triangles();
-		if(++count_op%stats_freq==0){
-			if(triangles_exact == 0){
-				continue; // No error possibile !
-			}
-			Result res = local_err(counter_exact,sampler_exact,counter,*sampler);
-			cout << count_op << "\t"<<counter.size_sample()<<"\t"<<triangles_exact<< "\t" <<res.top_triangle_exact<<"\t"<<res.top_triangle_est<<"\t" <<res.pearson<<"\t"<<res.mean_eps_err<<endl;
-		}
+//	Statsstats(stats_freq);
+	PerfCounters perf_counters;
+	if (perf) {
+		perf_counters.open();
+	}
+	GroundTruthReader truth;
+	if (!truth_file.empty() && is_window) {
+		cerr << "ERROR the ground truth files are of the whole stream, not of a window." << endl;
+		exit(1);
+	}
+	if (!truth_file.empty() && !truth.open(truth_file)) {
+		cerr << "ERROR " << truth_file << " is not a ground truth file." << endl;
+		exit(1);
 	}
+	UpdateLoop loop = {&scheduler, &counter, &sampler_exact, only_add, stats_freq,
+			perf ? &perf_counters : NULL, num_threads, truth_file.empty() ? NULL : &truth, window_length};
+	run_with_static_type(sampler, loop);
 	//stats.end_op();
 
 	delete sampler;
@@ -0,0 +1,100 @@
+#ifndef SAMPLERDRIVER_H_
+#define SAMPLERDRIVER_H_
+
+#include "GraphSampler.h"
+#include "Profile.h"
+
+#include <typeinfo>
+#include <vector>
+
+using namespace std;
+
+// Static dispatch of the per-update calls. The loops over the updates are
+// templates on the sampler type and call the sampler with the functions
+// below: for the samplers of GraphSampler.h these are not virtual calls and
+// can be inlined (across files with -flto). With static type GraphSampler
+// (e.g. samplers defined elsewhere) they are the usual virtual calls.
+
+template <class Sampler>
+inline void exec_operation(Sampler* sampler, const EdgeUpdate& update){
+	PROFILE_PHASE(PHASE_SAMPLING);
+	sampler->Sampler::exec_operation(update);
+}
+inline void exec_operation(GraphSampler* sampler, const EdgeUpdate& update){
+	PROFILE_PHASE(PHASE_SAMPLING);
+	sampler->exec_operation(update);
+}
+
+template <class Sampler>
+inline void exec_batch(Sampler* sampler, const vector<EdgeUpdate>& updates){
+	PROFILE_PHASE(PHASE_SAMPLING);
+	for (const auto& update: updates){
+		sampler->Sampler::exec_operation(update);
+	}
+}
+inline void exec_batch(GraphSampler* sampler, const vector<EdgeUpdate>& updates){
+	PROFILE_PHASE(PHASE_SAMPLING);
+	sampler->exec_batch(updates);
+}
+
+template <class Sampler>
+inline double get_triangle_est_local(Sampler* sampler, int n){
+	return sampler->Sampler::get_triangle_est_local(n);
+}
+inline double get_triangle_est_local(GraphSampler* sampler, int n){
+	return sampler->get_triangle_est_local(n);
+}
+
+// Triangles and edges in the sample: those of the counter of the sampler,
+// except for ExactSampler that has no counter (and the triangles of ThinkD).
+template <class Sampler>
+inline unsigned long long sample_triangles(Sampler*, const TriangleCounter* counter){
+	return counter->triangles();
+}
+inline unsigned long long sample_triangles(ExactSampler* sampler, const TriangleCounter*){
+	return sampler->triangles();
+}
+// The counter of ThinkD has the triangles found at the additions
+inline unsigned long long sample_triangles(ThinkDSampler* sampler, const TriangleCounter*){
+	return sampler->sample_triangles();
+}
+template <class Sampler>
+inline int sample_size(Sampler*, const TriangleCounter* counter){
+	return counter->size_sample();
+}
+inline int sample_size(ExactSampler* sampler, const TriangleCounter*){
+	return sampler->num_edges();
+}
+
+// Calls driver.run(sampler) with the sampler cast to its dynamic type, if
+// that is one of the samplers of GraphSampler.h, or as a GraphSampler*.
+// Driver has a member template <class Sampler> void run(Sampler* sampler).
+template <class Driver>
+void run_with_static_type(GraphSampler* sampler, Driver& driver){
+	const type_info& type = typeid(*sampler);
+	if (type == typeid(ReservoirSampler)){
+		driver.run(static_cast<ReservoirSampler*>(sampler));
+	} else if (type == typeid(ReservoirAddRemSampler)){
+		driver.run(static_cast<ReservoirAddRemSampler*>(sampler));
+	} else if (type == typeid(FixedPSampler)){
+		driver.run(static_cast<FixedPSampler*>(sampler));
+	} else if (type == typeid(ExactSampler)){
+		driver.run(static_cast<ExactSampler*>(sampler));
+	} else if (type == typeid(CoordinatedSampler)){
+		driver.run(static_cast<CoordinatedSampler*>(sampler));
+	} else if (type == typeid(ThinkDSampler)){
+		driver.run(static_cast<ThinkDSampler*>(sampler));
+	} else if (type == typeid(WaitingRoomSampler)){
+		driver.run(static_cast<WaitingRoomSampler*>(sampler));
+	} else if (type == typeid(SlidingWindowSampler)){
+		driver.run(static_cast<SlidingWindowSampler*>(sampler));
+	} else if (type == typeid(PinarSampler)){
+		driver.run(static_cast<PinarSampler*>(sampler));
+	} else if (type == typeid(PavanSampler)){
+		driver.run(static_cast<PavanSampler*>(sampler));
+	} else {
+		driver.run(sampler);
+	}
+}
+
+#endif /* SAMPLERDRIVER_H_ */
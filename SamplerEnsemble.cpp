@@ -0,0 +1,157 @@
+#include "SamplerEnsemble.h"
+#include "SamplerDriver.h"
+#include <cassert>
+
+using namespace std;
+
+MultiSampler::MultiSampler(size_t num_instances, bool local, const SamplerFactory& factory)
+	: GraphSampler(NULL/* each instance has its own counter*/),
+	  pending_(NULL), generation_(0), running_(0), stop_(false){
+	assert(num_instances > 0);
+	for (size_t i = 0; i < num_instances; i++){
+		counters_.push_back(new TriangleCounter(local));
+		samplers_.push_back(factory(counters_.back()));
+	}
+	for (size_t i = 1; i < num_instances; i++){
+		workers_.push_back(thread(&MultiSampler::run_worker, this, i));
+	}
+}
+
+MultiSampler::~MultiSampler(){
+	{
+		lock_guard<mutex> lock(mutex_);
+		stop_ = true;
+	}
+	batch_ready_.notify_all();
+	for (auto& worker: workers_){
+		worker.join();
+	}
+	for (size_t i = 0; i < samplers_.size(); i++){
+		delete samplers_[i];
+		delete counters_[i];
+	}
+}
+
+// Executes a batch with the static type of the sampler
+struct BatchDriver {
+	const vector<EdgeUpdate>* batch;
+
+	template <class Sampler>
+	void run(Sampler* sampler){
+		exec_batch(sampler, *batch);
+	}
+};
+
+void MultiSampler::exec_parallel(const vector<const vector<EdgeUpdate>*>& batches){
+	assert(batches.size() == samplers_.size());
+	// The instances share no state, the calling thread runs the first one
+	// while the workers run the others.
+	{
+		lock_guard<mutex> lock(mutex_);
+		pending_ = &batches;
+		running_ = workers_.size();
+		generation_++;
+	}
+	batch_ready_.notify_all();
+	BatchDriver driver = {batches[0]};
+	run_with_static_type(samplers_[0], driver);
+	unique_lock<mutex> lock(mutex_);
+	batch_done_.wait(lock, [this]() { return running_ == 0; });
+	pending_ = NULL;
+}
+
+void MultiSampler::run_worker(size_t i){
+	unsigned long long executed = 0; // generation of the last batch executed
+	unique_lock<mutex> lock(mutex_);
+	while (true){
+		batch_ready_.wait(lock, [&]() { return generation_ != executed || stop_; });
+		if (generation_ == executed){
+			return; // stopped
+		}
+		executed = generation_;
+		const vector<EdgeUpdate>* batch = (*pending_)[i];
+		lock.unlock();
+		if (!batch->empty()){
+			BatchDriver driver = {batch};
+			run_with_static_type(samplers_[i], driver);
+		}
+		lock.lock();
+		if (--running_ == 0){
+			batch_done_.notify_one();
+		}
+	}
+}
+
+// Triangles in the sample of an instance (see sample_triangles)
+struct SampleTrianglesDriver {
+	const TriangleCounter* counter;
+	unsigned long long int triangles;
+
+	template <class Sampler>
+	void run(Sampler* sampler){
+		triangles = sample_triangles(sampler, counter);
+	}
+};
+
+unsigned long long int MultiSampler::triangles() const{
+	unsigned long long int sum = 0;
+	for (size_t i = 0; i < samplers_.size(); i++){
+		SampleTrianglesDriver driver = {counters_[i], 0};
+		run_with_static_type(samplers_[i], driver);
+		sum += driver.triangles;
+	}
+	return sum;
+}
+
+int MultiSampler::size_sample() const{
+	int sum = 0;
+	for (const auto& counter: counters_){
+		sum += counter->size_sample();
+	}
+	return sum;
+}
+
+void MultiSampler::memory_usage(MemoryUsage* usage) const{
+	for (const auto& sampler: samplers_){
+		sampler->memory_usage(usage);
+	}
+}
+
+SamplerEnsemble::SamplerEnsemble(size_t num_instances, bool local, const SamplerFactory& factory)
+	: MultiSampler(num_instances, local, factory){
+}
+
+SamplerEnsemble::~SamplerEnsemble(){}
+
+void SamplerEnsemble::exec_operation(const EdgeUpdate& update){
+	for (auto& sampler: samplers_){
+		sampler->exec_operation(update);
+	}
+}
+
+void SamplerEnsemble::exec_batch(const vector<EdgeUpdate>& updates){
+	exec_parallel(vector<const vector<EdgeUpdate>*>(samplers_.size(), &updates));
+}
+
+double SamplerEnsemble::get_triangle_est(){
+	double sum = 0;
+	for (auto& sampler: samplers_){
+		sum += sampler->get_triangle_est();
+	}
+	return sum / samplers_.size();
+}
+
+double SamplerEnsemble::get_triangle_est_local(int n){
+	double sum = 0;
+	for (auto& sampler: samplers_){
+		sum += sampler->get_triangle_est_local(n);
+	}
+	return sum / samplers_.size();
+}
+
+void SamplerEnsemble::instance_estimates(vector<double>* estimates){
+	estimates->clear();
+	for (auto& sampler: samplers_){
+		estimates->push_back(sampler->get_triangle_est());
+	}
+}
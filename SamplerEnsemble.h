@@ -0,0 +1,68 @@
+#ifndef SAMPLERENSEMBLE_H_
+#define SAMPLERENSEMBLE_H_
+
+#include "GraphSampler.h"
+#include "TriangleCounter.h"
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Creates a sampler using the given counter (the counter is owned by the caller).
+typedef function<GraphSampler*(TriangleCounter* counter)> SamplerFactory;
+
+// Set of K samplers, each with its own counter, that can be run in parallel.
+class MultiSampler: public GraphSampler {
+public:
+	MultiSampler(size_t num_instances, bool local, const SamplerFactory& factory);
+	virtual ~MultiSampler();
+
+	inline size_t num_instances() const {
+		return samplers_.size();
+	}
+	// Sum over the instances of the triangles / edges in the samples
+	unsigned long long int triangles() const;
+	int size_sample() const;
+	void memory_usage(MemoryUsage* usage) const;
+
+protected:
+	// Instance i executes *batches[i]. The calling thread runs the instance 0,
+	// the others are run by workers started with the sampler.
+	void exec_parallel(const vector<const vector<EdgeUpdate>*>& batches);
+
+	vector<TriangleCounter*> counters_;
+	vector<GraphSampler*> samplers_;
+
+private:
+	// Runs the instance i on each batch handed by exec_parallel, until stopped
+	void run_worker(size_t i);
+
+	mutex mutex_;
+	condition_variable batch_ready_;
+	condition_variable batch_done_;
+	const vector<const vector<EdgeUpdate>*>* pending_; // batches being executed
+	unsigned long long generation_; // batches handed to the workers so far
+	size_t running_; // workers still executing the pending batches
+	bool stop_;
+	vector<thread> workers_; // worker i runs the instance i+1
+};
+
+// K independent samplers fed with the same updates. The estimate is the mean
+// of the K estimates.
+class SamplerEnsemble: public MultiSampler {
+public:
+	SamplerEnsemble(size_t num_instances, bool local, const SamplerFactory& factory);
+	virtual ~SamplerEnsemble();
+
+	void exec_operation(const EdgeUpdate& update);
+	void exec_batch(const vector<EdgeUpdate>& updates);
+	double get_triangle_est();
+	double get_triangle_est_local(int n);
+
+	void instance_estimates(vector<double>* estimates);
+};
+
+#endif /* SAMPLERENSEMBLE_H_ */
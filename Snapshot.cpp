@@ -0,0 +1,68 @@
+#include "Snapshot.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+void SnapshotWriter::put_string(const string& value){
+	put((unsigned long long)value.size());
+	buffer_.insert(buffer_.end(), value.begin(), value.end());
+}
+
+bool SnapshotWriter::write(const string& file_name) const{
+	string tmp_name = file_name + ".tmp";
+	FILE* file = fopen(tmp_name.c_str(), "wb");
+	if (file == NULL){
+		return false;
+	}
+	bool ok = fwrite(buffer_.data(), 1, buffer_.size(), file) == buffer_.size();
+	ok = (fclose(file) == 0) && ok;
+	if (!ok){
+		remove(tmp_name.c_str());
+		return false;
+	}
+	return rename(tmp_name.c_str(), file_name.c_str()) == 0;
+}
+
+SnapshotReader::SnapshotReader() : data_(NULL), size_(0), pos_(0){
+}
+
+SnapshotReader::~SnapshotReader(){
+	if (data_ != NULL){
+		munmap(const_cast<char*>(data_), size_);
+	}
+}
+
+bool SnapshotReader::open(const string& file_name){
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd < 0){
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0){
+		close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED){
+		return false;
+	}
+	data_ = static_cast<const char*>(data);
+	size_ = file_stat.st_size;
+	pos_ = 0;
+	return true;
+}
+
+bool SnapshotReader::get_string(string* value){
+	unsigned long long length = 0;
+	if (!get(&length) || length > size_ - pos_){
+		return false;
+	}
+	value->assign(data_ + pos_, length);
+	pos_ += length;
+	return true;
+}
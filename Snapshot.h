@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <type_traits>
+
+using namespace std;
+
+// Compact binary snapshots: values are appended in order (raw bytes, the file
+// is only meant to be read back on the same architecture) and read back in
+// the same order from the mmap-ed file.
+
+class SnapshotWriter {
+public:
+	template <class T>
+	void put(const T& value){
+		static_assert(is_standard_layout<T>::value && is_trivially_destructible<T>::value, "only plain values");
+		const char* bytes = reinterpret_cast<const char*>(&value);
+		buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+	}
+	template <class T>
+	void put_vector(const vector<T>& values){
+		static_assert(is_standard_layout<T>::value && is_trivially_destructible<T>::value, "only plain values");
+		put((unsigned long long)values.size());
+		const char* bytes = reinterpret_cast<const char*>(values.data());
+		buffer_.insert(buffer_.end(), bytes, bytes + values.size()*sizeof(T));
+	}
+	void put_string(const string& value);
+
+	// Writes a temporary file renamed to file_name, so an existing snapshot
+	// is replaced only by a complete one. Returns false on error.
+	bool write(const string& file_name) const;
+
+private:
+	vector<char> buffer_;
+};
+
+class SnapshotReader {
+public:
+	SnapshotReader();
+	virtual ~SnapshotReader();
+
+	// Maps the file in memory. Returns false on error.
+	bool open(const string& file_name);
+
+	// All the getters return false if the snapshot ends before the value.
+	template <class T>
+	bool get(T* value){
+		static_assert(is_standard_layout<T>::value && is_trivially_destructible<T>::value, "only plain values");
+		if (pos_ + sizeof(T) > size_){
+			return false;
+		}
+		memcpy((void*)value, data_ + pos_, sizeof(T));
+		pos_ += sizeof(T);
+		return true;
+	}
+	template <class T>
+	bool get_vector(vector<T>* values){
+		static_assert(is_standard_layout<T>::value && is_trivially_destructible<T>::value, "only plain values");
+		unsigned long long count = 0;
+		if (!get(&count) || count > (size_ - pos_)/sizeof(T)){
+			return false;
+		}
+		values->resize(count);
+		memcpy((void*)values->data(), data_ + pos_, count*sizeof(T));
+		pos_ += count*sizeof(T);
+		return true;
+	}
+	bool get_string(string* value);
+
+private:
+	const char* data_;
+	size_t size_;
+	size_t pos_;
+};
+
+#endif /* SNAPSHOT_H_ */
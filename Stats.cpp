@@ -1,5 +1,7 @@
 
 #include "Stats.h"
+#include "StatsSinks.h"
+#include "Profile.h"
 #include <cstring>
 #include <ctime>
 #include <cassert>
@@ -9,15 +11,37 @@
 
 using namespace std;
 
+Stats::Stats(const int stat_window_size, size_t retained_windows) :
+		stat_window_size_(stat_window_size), started_(false), sink_(new TsvStatsSink(&cout)),
+		retained_(retained_windows), num_stats_(0), op_count_(0) {
+
+	add_count_window_ = remove_count_window_ = 0;
+	last_triangles_est_ = last_triangles_count_ = last_size_sample_ = 0;
+	last_op_count_ = 0;
+	assert(retained_windows > 0);
+}
+
 Stats::~Stats() {
+	sink_->flush();
 }
 
-#define SEPARATOR "\t"
+void Stats::set_sink(StatsSink* sink) {
+	assert(!started_);
+	sink_.reset(sink);
+}
 
 void Stats::reset_window() {
-	Stat new_stat;
+	// The oldest retained stat is replaced
+	Stat& new_stat = retained_[num_stats_ % retained_.size()];
+	num_stats_++;
+	new_stat.extra.clear();
+
+	if (estimate_callback_) {
+		PROFILE_PHASE(PHASE_ESTIMATE);
+		last_triangles_est_ = estimate_callback_();
+	}
 
-	auto now = std::chrono::system_clock::now();
+	auto now = std::chrono::steady_clock::now();
 	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
 			now - last_time_);
 	new_stat.micros = elapsed.count();
@@ -33,38 +57,56 @@ void Stats::reset_window() {
 	new_stat.micros_per_op = new_stat.micros / new_stat.operation_num;
 	new_stat.last_timestamp = last_timestamp_;
 	new_stat.last_size_sample = last_size_sample_;
+	for (const auto& callback: columns_callbacks_) {
+		callback(&new_stat.extra);
+	}
+	assert(new_stat.extra.size() == extra_columns_.size());
 
 	add_count_window_ = 0;
 	remove_count_window_ = 0;
 	last_op_count_ = op_count_;
 
-	stats_.push_back(new_stat);
+	sink_->write(new_stat);
 
-	cout << new_stat.op_count_total << SEPARATOR << new_stat.last_timestamp << SEPARATOR
-			<< new_stat.last_triangles_count << SEPARATOR << new_stat.last_triangles_est << SEPARATOR
-			<< new_stat.last_size_sample << SEPARATOR << new_stat.operation_num
-			<< SEPARATOR << new_stat.micros << SEPARATOR << new_stat.micros_per_op << SEPARATOR
-			<< new_stat.add_op_in_window << SEPARATOR << new_stat.rem_op_in_window
-			<< endl;
+	last_time_ = std::chrono::steady_clock::now();
+}
 
-	now = std::chrono::system_clock::now();
-	last_time_ = now;
+void Stats::add_columns(const vector<string>& names, const ColumnsCallback& callback) {
+	assert(!started_);
+	extra_columns_.insert(extra_columns_.end(), names.begin(), names.end());
+	columns_callbacks_.push_back(callback);
 }
 
 void Stats::end_op() {
 	if (op_count_ != last_op_count_) {
 		reset_window();
 	}
+	sink_->flush();
 }
 
 void Stats::exec_op(bool is_add, unsigned long long last_triangles_count, double last_triangles_est, unsigned int last_size_sample, unsigned int last_timestamp) {
-	if (op_count_ == 0) {
-		last_time_ = std::chrono::system_clock::now();
-		cout << "op_count_total" << SEPARATOR << "last_timestamp" << SEPARATOR
-				<< "last_triangles_count" << SEPARATOR << "last_triangles_est" << SEPARATOR
-				<< "last_size_sample"<< SEPARATOR << "operation_num" << SEPARATOR
-				<< "micros_total" << SEPARATOR << "micros_per_op" << SEPARATOR
-				<< "add_op_in_window" << SEPARATOR << "rem_op_in_window" << endl;
+	last_triangles_est_ = last_triangles_est;
+	exec_op(is_add, last_triangles_count, last_size_sample, last_timestamp);
+}
+
+void Stats::start() {
+	if (started_) {
+		return;
+	}
+	started_ = true;
+	last_time_ = std::chrono::steady_clock::now();
+	vector<string> columns = {"op_count_total", "last_timestamp",
+			"last_triangles_count", "last_triangles_est",
+			"last_size_sample", "operation_num",
+			"micros_total", "micros_per_op",
+			"add_op_in_window", "rem_op_in_window"};
+	columns.insert(columns.end(), extra_columns_.begin(), extra_columns_.end());
+	sink_->header(columns);
+}
+
+void Stats::exec_op(bool is_add, unsigned long long last_triangles_count, unsigned int last_size_sample, unsigned int last_timestamp) {
+	if (!started_) {
+		start();
 	}
 
 	if (is_add) {
@@ -76,7 +118,6 @@ void Stats::exec_op(bool is_add, unsigned long long last_triangles_count, double
 	++op_count_;
 
 	last_triangles_count_ = last_triangles_count;
-	last_triangles_est_ = last_triangles_est;
 	last_size_sample_ = last_size_sample;
 
 	if (is_add){
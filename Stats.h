@@ -3,7 +3,12 @@
 #define STATS_H_
 
 #include <vector>
+#include <string>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cassert>
 
 using namespace std;
 
@@ -21,30 +26,69 @@ typedef struct Stat {
 	unsigned int last_timestamp;
 
 	unsigned int op_count_total;
+
+	vector<double> extra; // values of the extra columns, in order
 } Stat;
 
+class StatsSink; // see StatsSinks.h
+
+// Returns the current triangle estimate. Called only when a window is closed
+// (or on explicit request) instead of after every update.
+typedef function<double()> EstimateCallback;
+// Appends the values of a group of extra columns when a window is closed.
+typedef function<void(vector<double>*)> ColumnsCallback;
+
 class Stats {
 public:
-	explicit Stats(const int stat_window_size) :
-			stat_window_size_(stat_window_size), op_count_(0) {
-
-		add_count_window_ = remove_count_window_ = 0;
-		last_triangles_est_ = last_triangles_count_ = last_size_sample_ = 0;
-		last_op_count_ = 0;
-	}
+	// Keeps the last retained_windows stats in memory. Writes a TSV to cout
+	// unless another sink is set.
+	explicit Stats(const int stat_window_size, size_t retained_windows = 1024);
 	virtual ~Stats();
 
 	void exec_op(bool is_add, unsigned long long last_triangles_count, double last_triangles_est, unsigned int last_size_sample, unsigned int timestamp);
+	// As above but the estimate is pulled from the estimate callback.
+	void exec_op(bool is_add, unsigned long long last_triangles_count, unsigned int last_size_sample, unsigned int timestamp);
 	void end_op();
+	// Prints the header and starts the clock of the first window (done by the first operation if not called).
+	void start();
+	// Continues the count of a run restored after op_count operations.
+	void resume(unsigned int op_count) {
+		op_count_ = last_op_count_ = op_count;
+	}
 
-	const vector<Stat> stats() {
-		return stats_;
+	void set_estimate_callback(const EstimateCallback& callback) {
+		estimate_callback_ = callback;
+	}
+	// Estimate after the last update (requires the estimate callback).
+	double current_estimate() {
+		return estimate_callback_();
+	}
+	// Updates and estimate of the window being closed, for the columns callbacks.
+	unsigned int op_count() const {
+		return op_count_;
+	}
+	double last_estimate() const {
+		return last_triangles_est_;
+	}
+	// Adds a group of columns after the default ones, must be called before the first operation.
+	void add_columns(const vector<string>& names, const ColumnsCallback& callback);
+	// Replaces the sink (takes ownership), must be called before the first operation.
+	void set_sink(StatsSink* sink);
+
+	// Stats retained, i = 0 is the oldest one
+	size_t num_stats() const {
+		return min(num_stats_, retained_.size());
+	}
+	const Stat& stat(size_t i) const {
+		assert(i < num_stats());
+		return retained_[(num_stats_ - num_stats() + i) % retained_.size()];
 	}
 
 private:
 	void reset_window();
 
 	const unsigned int stat_window_size_;
+	bool started_;
 
 	unsigned int add_count_window_;
 	unsigned int remove_count_window_;
@@ -56,10 +100,17 @@ private:
 	unsigned int last_op_count_;
 	unsigned int last_timestamp_;
 
-	std::chrono::system_clock::time_point last_time_;
+	std::chrono::steady_clock::time_point last_time_;
+
+	EstimateCallback estimate_callback_;
+	vector<string> extra_columns_;
+	vector<ColumnsCallback> columns_callbacks_;
+	unique_ptr<StatsSink> sink_;
+
+	vector<Stat> retained_; // ring of the last stats
+	size_t num_stats_; // stats produced so far
 
 	unsigned int op_count_;
-	vector<Stat> stats_;
 };
 
 #endif /* STATS_H_ */
@@ -0,0 +1,142 @@
+#include "StatsSinks.h"
+#include <cassert>
+
+using namespace std;
+
+#define SEPARATOR "\t"
+// Bytes buffered by TsvStatsSink before writing them out
+#define TSV_BUFFER_SIZE (1<<16)
+
+StatsSink::~StatsSink() {
+}
+
+TsvStatsSink::TsvStatsSink(ostream* out) : out_(out) {
+}
+
+TsvStatsSink::~TsvStatsSink() {
+	flush();
+}
+
+void TsvStatsSink::header(const vector<string>& columns) {
+	for (size_t i = 0; i < columns.size(); i++) {
+		buffer_ << (i > 0 ? SEPARATOR : "") << columns[i];
+	}
+	buffer_ << '\n';
+}
+
+void TsvStatsSink::write(const Stat& stat) {
+	buffer_ << stat.op_count_total << SEPARATOR << stat.last_timestamp << SEPARATOR
+			<< stat.last_triangles_count << SEPARATOR << stat.last_triangles_est << SEPARATOR
+			<< stat.last_size_sample << SEPARATOR << stat.operation_num
+			<< SEPARATOR << stat.micros << SEPARATOR << stat.micros_per_op << SEPARATOR
+			<< stat.add_op_in_window << SEPARATOR << stat.rem_op_in_window;
+	for (const auto& value: stat.extra) {
+		buffer_ << SEPARATOR << value;
+	}
+	buffer_ << '\n';
+	if (buffer_.tellp() >= TSV_BUFFER_SIZE) {
+		flush();
+	}
+}
+
+void TsvStatsSink::flush() {
+	*out_ << buffer_.str();
+	out_->flush();
+	buffer_.str("");
+}
+
+BinaryStatsSink::BinaryStatsSink(const string& file_name) {
+	file_ = fopen(file_name.c_str(), "wb");
+}
+
+BinaryStatsSink::~BinaryStatsSink() {
+	if (file_ != NULL) {
+		fclose(file_);
+	}
+}
+
+void BinaryStatsSink::header(const vector<string>& columns) {
+	assert(ok());
+	fputs("TRIEST-STATS-1\n", file_);
+	unsigned int num_columns = columns.size();
+	fwrite(&num_columns, sizeof(num_columns), 1, file_);
+	for (const auto& column: columns) {
+		fputs(column.c_str(), file_);
+		fputc('\n', file_);
+	}
+}
+
+void BinaryStatsSink::write(const Stat& stat) {
+	record_.clear();
+	record_.push_back(stat.op_count_total);
+	record_.push_back(stat.last_timestamp);
+	record_.push_back(stat.last_triangles_count);
+	record_.push_back(stat.last_triangles_est);
+	record_.push_back(stat.last_size_sample);
+	record_.push_back(stat.operation_num);
+	record_.push_back(stat.micros);
+	record_.push_back(stat.micros_per_op);
+	record_.push_back(stat.add_op_in_window);
+	record_.push_back(stat.rem_op_in_window);
+	record_.insert(record_.end(), stat.extra.begin(), stat.extra.end());
+	fwrite(record_.data(), sizeof(double), record_.size(), file_);
+}
+
+void BinaryStatsSink::flush() {
+	fflush(file_);
+}
+
+AsyncStatsSink::AsyncStatsSink(StatsSink* sink, size_t max_queued)
+	: sink_(sink), max_queued_(max_queued), busy_(false), stop_(false), writer_(&AsyncStatsSink::run, this) {
+	assert(max_queued > 0);
+}
+
+AsyncStatsSink::~AsyncStatsSink() {
+	flush();
+	{
+		lock_guard<mutex> lock(mutex_);
+		stop_ = true;
+	}
+	changed_.notify_all();
+	writer_.join();
+}
+
+// Called before the first write, when the writer has nothing to do.
+void AsyncStatsSink::header(const vector<string>& columns) {
+	lock_guard<mutex> lock(mutex_);
+	assert(queue_.empty() && !busy_);
+	sink_->header(columns);
+}
+
+void AsyncStatsSink::write(const Stat& stat) {
+	{
+		unique_lock<mutex> lock(mutex_);
+		changed_.wait(lock, [this]() { return queue_.size() < max_queued_; });
+		queue_.push_back(stat);
+	}
+	changed_.notify_all();
+}
+
+void AsyncStatsSink::flush() {
+	unique_lock<mutex> lock(mutex_);
+	changed_.wait(lock, [this]() { return queue_.empty() && !busy_; });
+	sink_->flush();
+}
+
+void AsyncStatsSink::run() {
+	unique_lock<mutex> lock(mutex_);
+	while (true) {
+		changed_.wait(lock, [this]() { return !queue_.empty() || stop_; });
+		if (queue_.empty()) {
+			return; // stopped
+		}
+		Stat stat = queue_.front();
+		queue_.pop_front();
+		busy_ = true;
+		lock.unlock();
+		sink_->write(stat);
+		lock.lock();
+		busy_ = false;
+		changed_.notify_all();
+	}
+}
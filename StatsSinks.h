@@ -0,0 +1,90 @@
+#ifndef STATSSINKS_H_
+#define STATSSINKS_H_
+
+#include "Stats.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <cstdio>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Destination of the stats: the column names once, then one Stat per window.
+class StatsSink {
+public:
+	virtual ~StatsSink();
+	virtual void header(const vector<string>& columns) = 0;
+	virtual void write(const Stat& stat) = 0;
+	// Writes what is buffered (called at the end of the run)
+	virtual void flush() = 0;
+};
+
+// Tab-separated lines, buffered and written to out when the buffer is full
+// or on flush (not at every window).
+class TsvStatsSink: public StatsSink {
+public:
+	explicit TsvStatsSink(ostream* out);
+	virtual ~TsvStatsSink();
+	void header(const vector<string>& columns);
+	void write(const Stat& stat);
+	void flush();
+
+private:
+	ostream* out_;
+	ostringstream buffer_;
+};
+
+// Binary file: the string "TRIEST-STATS-1\n", the number of columns (uint32),
+// the column names ('\n' terminated), then a record of doubles per window
+// (one per column, in order).
+class BinaryStatsSink: public StatsSink {
+public:
+	explicit BinaryStatsSink(const string& file_name);
+	virtual ~BinaryStatsSink();
+	// False if the file cannot be written
+	bool ok() const {
+		return file_ != NULL;
+	}
+	void header(const vector<string>& columns);
+	void write(const Stat& stat);
+	void flush();
+
+private:
+	FILE* file_;
+	vector<double> record_;
+};
+
+// Hands the stats to another sink run on a writer thread, so the updates are
+// not delayed by the output.
+class AsyncStatsSink: public StatsSink {
+public:
+	// Takes ownership of sink. write blocks while max_queued stats are
+	// waiting for the writer, so a slow sink bounds the memory of the queue.
+	explicit AsyncStatsSink(StatsSink* sink, size_t max_queued = 1024);
+	virtual ~AsyncStatsSink();
+	void header(const vector<string>& columns);
+	void write(const Stat& stat);
+	// Waits until all the stats are written
+	void flush();
+
+private:
+	void run();
+
+	unique_ptr<StatsSink> sink_;
+	mutex mutex_;
+	condition_variable changed_;
+	deque<Stat> queue_;
+	const size_t max_queued_;
+	bool busy_; // the writer is writing a stat out of the queue
+	bool stop_;
+	thread writer_;
+};
+
+#endif /* STATSSINKS_H_ */
@@ -0,0 +1,171 @@
+#include "Summary.h"
+#include <cassert>
+#include <algorithm>
+#include <unordered_set>
+
+using namespace std;
+
+#define SUMMARY_MAGIC "TRIEST-SUMMARY-1"
+
+double EdgeSummary::prob_sampling_triangle() const{
+	if (kind == COORDINATED){
+		return threshold*threshold*threshold;
+	}
+	if (edges <= size){
+		return 1.0;
+	}
+	double p = ((double)size/edges)*((double)(size-1)/(edges-1))
+			*((double)(size-2)/(edges-2));
+	return min(p, 1.0);
+}
+
+double EdgeSummary::triangle_est() const{
+	double p = prob_sampling_triangle();
+	if (p <= 0){
+		return 0; // no triangles in the sample
+	}
+	TriangleCounter counter(false /*no local count*/);
+	for (const auto& edge: sample){
+		counter.add_triangles(edge.first, edge.second, 1.0);
+		counter.add_edge_sample(edge.first, edge.second);
+	}
+	return counter.triangles()/p;
+}
+
+void EdgeSummary::save(SnapshotWriter* out) const{
+	out->put(kind);
+	out->put(size);
+	out->put(edges);
+	out->put(hash_seed);
+	out->put(threshold);
+	out->put_vector(sample);
+}
+
+bool EdgeSummary::load(SnapshotReader* in){
+	return in->get(&kind) && (kind == UNIFORM || kind == COORDINATED)
+			&& in->get(&size) && in->get(&edges) && in->get(&hash_seed)
+			&& in->get(&threshold) && in->get_vector(&sample);
+}
+
+// The union of the samples contains all the edges of the union of the streams
+// with hash < min threshold, which are kept up to size edges.
+static bool merge_coordinated(const vector<EdgeSummary>& summaries, unsigned long long size,
+		EdgeSummary* merged){
+	double threshold = 1.0;
+	for (const auto& summary: summaries){
+		if (summary.hash_seed != summaries[0].hash_seed){
+			return false;
+		}
+		threshold = min(threshold, summary.threshold);
+	}
+
+	vector<pair<double, pair<int,int>>> hashed_edges;
+	for (const auto& summary: summaries){
+		for (const auto& edge: summary.sample){
+			double hash = edge_hash_01(edge.first, edge.second, summary.hash_seed);
+			if (hash < threshold){
+				hashed_edges.push_back(make_pair(hash, edge));
+			}
+		}
+	}
+	sort(hashed_edges.begin(), hashed_edges.end());
+	hashed_edges.erase(unique(hashed_edges.begin(), hashed_edges.end()), hashed_edges.end());
+	if (hashed_edges.size() > size){
+		threshold = hashed_edges[size].first;
+		hashed_edges.resize(size);
+	}
+
+	merged->kind = EdgeSummary::COORDINATED;
+	merged->size = size;
+	merged->edges = 0;
+	merged->hash_seed = summaries[0].hash_seed;
+	merged->threshold = threshold;
+	merged->sample.clear();
+	for (const auto& hashed_edge: hashed_edges){
+		merged->sample.push_back(hashed_edge.second);
+	}
+	return true;
+}
+
+// A uniform sample of the union of disjoint streams takes from each stream a
+// number of edges distributed as in sampling without replacement from the
+// union (multivariate hypergeometric), then a uniform subset of that size of
+// the sample of the stream.
+static bool merge_uniform(const vector<EdgeSummary>& summaries, unsigned long long size,
+		mt19937& rng, EdgeSummary* merged){
+	unsigned long long total_edges = 0;
+	for (const auto& summary: summaries){
+		if (summary.sample.size() != min(summary.size, summary.edges)){
+			return false;
+		}
+		size = min(size, summary.size);
+		total_edges += summary.edges;
+	}
+
+	vector<unsigned long long> remaining;
+	for (const auto& summary: summaries){
+		remaining.push_back(summary.edges);
+	}
+	vector<unsigned long long> taken(summaries.size(), 0);
+	unsigned long long draws = min(size, total_edges);
+	for (unsigned long long d = 0; d < draws; d++){
+		unsigned long long r = uniform_int_distribution<unsigned long long>(0, total_edges-d-1)(rng);
+		size_t i = 0;
+		while (r >= remaining[i]){
+			r -= remaining[i];
+			i++;
+		}
+		remaining[i]--;
+		taken[i]++;
+	}
+
+	merged->kind = EdgeSummary::UNIFORM;
+	merged->size = size;
+	merged->edges = total_edges;
+	merged->hash_seed = 0;
+	merged->threshold = 1.0;
+	merged->sample.clear();
+	unordered_set<pair<int,int>> seen;
+	for (size_t i = 0; i < summaries.size(); i++){
+		vector<pair<int,int>> sample = summaries[i].sample;
+		assert(taken[i] <= sample.size());
+		for (unsigned long long j = 0; j < taken[i]; j++){
+			swap(sample[j], sample[j + uniform_int_distribution<size_t>(0, sample.size()-j-1)(rng)]);
+			if (!seen.insert(sample[j]).second){
+				return false; // the streams are not disjoint
+			}
+			merged->sample.push_back(sample[j]);
+		}
+	}
+	return true;
+}
+
+bool merge_summaries(const vector<EdgeSummary>& summaries, unsigned long long size,
+		mt19937& rng, EdgeSummary* merged){
+	if (summaries.empty() || size < 3){
+		return false;
+	}
+	for (const auto& summary: summaries){
+		if (summary.kind != summaries[0].kind){
+			return false;
+		}
+	}
+	if (summaries[0].kind == EdgeSummary::COORDINATED){
+		return merge_coordinated(summaries, size, merged);
+	}
+	return merge_uniform(summaries, size, rng, merged);
+}
+
+bool write_summary_file(const string& file_name, const EdgeSummary& summary){
+	SnapshotWriter out;
+	out.put_string(SUMMARY_MAGIC);
+	summary.save(&out);
+	return out.write(file_name);
+}
+
+bool read_summary_file(const string& file_name, EdgeSummary* summary){
+	SnapshotReader in;
+	string magic;
+	return in.open(file_name) && in.get_string(&magic) && magic == SUMMARY_MAGIC
+			&& summary->load(&in);
+}
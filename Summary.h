@@ -0,0 +1,58 @@
+#ifndef SUMMARY_H_
+#define SUMMARY_H_
+
+#include "TriangleCounter.h"
+#include "Snapshot.h"
+
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace std;
+
+// Sample of an insertion-only edge stream that can be merged with the
+// samples of other streams into the sample of the union of the streams.
+//
+// UNIFORM: uniform sample of min(size, edges) of the edges of the stream (the
+// reservoir of ReservoirSampler). Only summaries of disjoint streams can be
+// merged.
+// COORDINATED: the edges with hash < threshold, where the threshold is the
+// hash of the (size+1)-th smallest edge (1 if the stream has fewer edges), as
+// kept by CoordinatedSampler. The same edge has the same hash in all the
+// streams (same hash_seed), so overlapping streams can be merged.
+typedef struct EdgeSummary {
+	enum Kind {
+		UNIFORM, COORDINATED
+	};
+	Kind kind;
+	unsigned long long size; // max number of edges in the sample
+	unsigned long long edges; // UNIFORM only: edges in the stream
+	unsigned long long hash_seed; // COORDINATED only
+	double threshold; // COORDINATED only
+	vector<pair<int,int>> sample;
+
+	// Prob of a triangle of the stream being in the sample
+	double prob_sampling_triangle() const;
+	// Unbiased estimate of the triangles of the stream
+	double triangle_est() const;
+
+	void save(SnapshotWriter* out) const;
+	bool load(SnapshotReader* in);
+} EdgeSummary;
+
+// Hash in [0,1) of the edge used by COORDINATED summaries
+inline double edge_hash_01(const int u, const int v, unsigned long long seed){
+	return (mix64(edge_to_id(u, v) ^ mix64(seed)) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Merges summaries of the same kind (and hash_seed) into a summary of the
+// union of the streams with at most size edges (for UNIFORM no more than the
+// size of the smallest one). Returns false if the summaries cannot be merged.
+bool merge_summaries(const vector<EdgeSummary>& summaries, unsigned long long size,
+		mt19937& rng, EdgeSummary* merged);
+
+// Summary files: a magic string followed by the summary. Return false on error.
+bool write_summary_file(const string& file_name, const EdgeSummary& summary);
+bool read_summary_file(const string& file_name, EdgeSummary* summary);
+
+#endif /* SUMMARY_H_ */
@@ -1,5 +1,6 @@
 
 #include "TriangleCounter.h"
+#include "MemoryUsage.h"
 #include <cassert>
 #include <iostream>
 
@@ -22,17 +23,18 @@ unsigned long long edge_to_id(const int u,
 }
 
 
-TriangleCounter::TriangleCounter(bool local) : local_(local), triangles_(0), edges_present_original_(0), triangles_weight_(0.0) {
+TriangleCounter::TriangleCounter(bool local) : local_(local), triangles_(0), edges_present_original_(0), triangles_weight_(0.0), sample_changes_(0) {
 }
 
 TriangleCounter::~TriangleCounter() {
 }
 
 
-bool TriangleCounter::add_edge_sample(const int u, const int v){
+bool TriangleCounter::add_edge_sample(const int u, const int v, const int slot){
 	assert(u!=v);
 
-	set_edge_ids_.insert(edge_to_id(u,v));
+	edge_slots_[edge_to_id(u,v)] = slot;
+	sample_changes_++;
 	bool succeed = graph_.add_edge(u,v);
 	//if (! succeed){
 	//	cerr<<"NOT SUCCED ADD: "<<u<< " "<<v<<endl;
@@ -44,90 +46,109 @@ bool TriangleCounter::add_edge_sample(const int u, const int v){
 bool TriangleCounter::remove_edge_sample(const int u, const int v){
 	assert(u!=v);
 
-	set_edge_ids_.erase(edge_to_id(u,v));
+	edge_slots_.erase(edge_to_id(u,v));
+	sample_changes_++;
 
 	return graph_.remove_edge(u,v);
 }
 
-void TriangleCounter::add_triangles(const int u, const int v, double weight){
+template <class F>
+inline void TriangleCounter::for_each_triangle(const int u, const int v, F f){
+	PROFILE_PHASE(PHASE_PROBE);
 	assert(u!=v);
 	int min_deg_n = (graph_.degree(u) <= graph_.degree(v) ? u : v);
 	int max_deg_n = (graph_.degree(u) <= graph_.degree(v) ? v : u);
 
 	vector<int> min_neighbors;
 	graph_.neighbors(min_deg_n, & min_neighbors);
+	PROFILE_COUNT(EVENT_NEIGHBORS_SCANNED, min_neighbors.size());
 
 	for(const auto& n : min_neighbors){
 		if(n!= max_deg_n){
-			if(set_edge_ids_.find(edge_to_id(n, max_deg_n)) != set_edge_ids_.end()){
-				double weight_to_use = 0.0;
-
-				if(edge_weight_.empty()){ // easy case used by most algorithms
-					weight_to_use = weight;
-				} else { // each triangle is weighted by the product of the weights of the edges
-					assert(weight = 1.0); //not used in this case
-					assert(edge_weight_[make_pair(u,v)]>0);
-					assert(edge_weight_[make_pair(u,n)]>0);
-					assert(edge_weight_[make_pair(v,n)]>0);
-					weight_to_use = edge_weight_.at(make_pair(u,v))*edge_weight_.at(make_pair(n,v))*edge_weight_.at(make_pair(u,n));
-				}
-				triangles_weight_ += weight_to_use;
-				triangles_ += 1;
-
-				if(local_){
-					triangles_local_map_[u]++;
-					triangles_local_map_[v]++;
-					triangles_local_map_[n]++;
-					triangles_weight_local_map_[u]+=weight_to_use;
-					triangles_weight_local_map_[v]+=weight_to_use;
-					triangles_weight_local_map_[n]+=weight_to_use;
-				}
+			PROFILE_COUNT(EVENT_EDGE_PROBES, 1);
+			if(edge_slots_.find(edge_to_id(n, max_deg_n)) != edge_slots_.end()){
+				PROFILE_COUNT(EVENT_TRIANGLES_FOUND, 1);
+				f(n);
 			}
 		}
 	}
 }
-void TriangleCounter::remove_triangles(const int u, const int v, double weight){
-	assert(u!=v);
-	int min_deg_n = (graph_.degree(u) <= graph_.degree(v) ? u : v);
-	int max_deg_n = (graph_.degree(u) <= graph_.degree(v) ? v : u);
 
-	vector<int> min_neighbors;
-	graph_.neighbors(min_deg_n, & min_neighbors);
+inline double TriangleCounter::triangle_weight(const int u, const int v, const int n, double weight){
+	if(edge_weight_.empty()){ // easy case used by most algorithms
+		return weight;
+	}
+	// each triangle is weighted by the product of the weights of the edges
+	assert(weight == 1.0); //not used in this case
+	assert(edge_weight_[make_pair(u,v)]>0);
+	assert(edge_weight_[make_pair(u,n)]>0);
+	assert(edge_weight_[make_pair(v,n)]>0);
+	return edge_weight_.at(make_pair(u,v))*edge_weight_.at(make_pair(n,v))*edge_weight_.at(make_pair(u,n));
+}
 
-	for(const auto& n : min_neighbors){
-		if(n!= max_deg_n){
-			if(set_edge_ids_.find(edge_to_id(n, max_deg_n)) != set_edge_ids_.end()){
-				double weight_to_use = 0.0;
-
-				if(edge_weight_.empty()){ // easy case used by most algorithms
-					weight_to_use = weight;
-				} else { // each triangle is weighted by the product of the weights of the edges
-					assert(weight = 1.0); //not used in this case
-					assert(edge_weight_[make_pair(u,v)]>0);
-					assert(edge_weight_[make_pair(u,n)]>0);
-					assert(edge_weight_[make_pair(v,n)]>0);
-					weight_to_use = edge_weight_.at(make_pair(u,v))*edge_weight_.at(make_pair(n,v))*edge_weight_.at(make_pair(u,n));
-				}
-				triangles_weight_ -= weight_to_use;
-				triangles_ -= 1;
-
-				if(local_){
-					triangles_local_map_[u]--;
-					triangles_local_map_[v]--;
-					triangles_local_map_[n]--;
-					triangles_weight_local_map_[u]-=weight_to_use;
-					triangles_weight_local_map_[v]-=weight_to_use;
-					triangles_weight_local_map_[n]-=weight_to_use;
-					// To avoid numerical error
-					triangles_weight_local_map_[u]= max(triangles_weight_local_map_[u], 0.0);
-					triangles_weight_local_map_[v]= max(triangles_weight_local_map_[v], 0.0);
-					triangles_weight_local_map_[n]= max(triangles_weight_local_map_[n], 0.0);
-				}
-			}
-		}
+inline void TriangleCounter::count_triangle(const int u, const int v, const int n, double weight){
+	triangles_weight_ += weight;
+	triangles_ += 1;
+
+	if(local_){
+		triangles_local_map_[u]++;
+		triangles_local_map_[v]++;
+		triangles_local_map_[n]++;
+		triangles_weight_local_map_[u]+=weight;
+		triangles_weight_local_map_[v]+=weight;
+		triangles_weight_local_map_[n]+=weight;
 	}
 }
 
+void TriangleCounter::add_triangles(const int u, const int v, double weight){
+	for_each_triangle(u, v, [&](int n){
+		count_triangle(u, v, n, triangle_weight(u, v, n, weight));
+	});
+}
+
+void TriangleCounter::add_triangles(const int u, const int v, const function<double(int)>& wedge_weight){
+	assert(edge_weight_.empty()); // edge weights not supported in this case
+	for_each_triangle(u, v, [&](int n){
+		count_triangle(u, v, n, wedge_weight(n));
+	});
+}
+
+void TriangleCounter::remove_triangles(const int u, const int v, double weight){
+	for_each_triangle(u, v, [&](int n){
+		double weight_to_use = triangle_weight(u, v, n, weight);
+		triangles_weight_ -= weight_to_use;
+		triangles_ -= 1;
+
+		if(local_){
+			triangles_local_map_[u]--;
+			triangles_local_map_[v]--;
+			triangles_local_map_[n]--;
+			triangles_weight_local_map_[u]-=weight_to_use;
+			triangles_weight_local_map_[v]-=weight_to_use;
+			triangles_weight_local_map_[n]-=weight_to_use;
+			// To avoid numerical error
+			triangles_weight_local_map_[u]= max(triangles_weight_local_map_[u], 0.0);
+			triangles_weight_local_map_[v]= max(triangles_weight_local_map_[v], 0.0);
+			triangles_weight_local_map_[n]= max(triangles_weight_local_map_[n], 0.0);
+		}
+	});
+}
+
+
+int TriangleCounter::remove_triangles_weight(const int u, const int v, double weight){
+	assert(edge_weight_.empty()); // edge weights not supported in this case
+	int found = 0;
+	for_each_triangle(u, v, [&](int n){
+		found++;
+		triangles_weight_ -= weight;
+		if(local_){
+			triangles_weight_local_map_[u]-=weight;
+			triangles_weight_local_map_[v]-=weight;
+			triangles_weight_local_map_[n]-=weight;
+		}
+	});
+	return found;
+}
 
 void TriangleCounter::new_update(const EdgeUpdate& update){
 	if(update.is_add){
@@ -140,20 +161,92 @@ void TriangleCounter::new_update(const EdgeUpdate& update){
 void TriangleCounter::clear() {
 	triangles_ = edges_present_original_ = triangles_weight_ = 0;
 	graph_.clear();
-	set_edge_ids_.clear();
+	edge_slots_.clear();
 	edge_weight_.clear();
 }
 
+size_t TriangleCounter::memory_bytes() const {
+	MemoryUsage usage;
+	memory_usage(&usage);
+	return usage.total();
+}
+
+void TriangleCounter::memory_usage(MemoryUsage* usage) const {
+	usage->bytes[MEMORY_GRAPH] += graph_.memory_bytes();
+	usage->bytes[MEMORY_EDGE_INDEX] += hashed_bytes(edge_slots_);
+	usage->bytes[MEMORY_LOCAL_COUNTS] += hashed_bytes(triangles_local_map_) + hashed_bytes(triangles_weight_local_map_);
+	usage->bytes[MEMORY_EDGE_WEIGHTS] += hashed_bytes(edge_weight_);
+}
+
+void TriangleCounter::save(SnapshotWriter* out, bool with_sample) const {
+	out->put(local_);
+	out->put(triangles_);
+	out->put(triangles_weight_);
+	out->put(edges_present_original_);
+	out->put_vector(vector<pair<int, unsigned long long>>(triangles_local_map_.begin(), triangles_local_map_.end()));
+	out->put_vector(vector<pair<int, double>>(triangles_weight_local_map_.begin(), triangles_weight_local_map_.end()));
+	vector<pair<pair<int,int>, double>> edge_weights(edge_weight_.begin(), edge_weight_.end());
+	out->put_vector(edge_weights);
+	if (with_sample) {
+		vector<pair<int, int>> edges;
+		graph_.edges(&edges); // both directions
+		vector<pair<int, int>> sample;
+		sample.reserve(edges.size()/2);
+		for (const auto& edge: edges) {
+			if (edge.first < edge.second) {
+				sample.push_back(edge);
+			}
+		}
+		out->put_vector(sample);
+	}
+}
+
+bool TriangleCounter::load(SnapshotReader* in, bool with_sample) {
+	clear();
+	triangles_local_map_.clear();
+	triangles_weight_local_map_.clear();
+
+	bool local = false;
+	vector<pair<int, unsigned long long>> local_counts;
+	vector<pair<int, double>> local_weights;
+	vector<pair<pair<int,int>, double>> edge_weights;
+	if (!in->get(&local) || local != local_ || !in->get(&triangles_)
+			|| !in->get(&triangles_weight_) || !in->get(&edges_present_original_)
+			|| !in->get_vector(&local_counts) || !in->get_vector(&local_weights)
+			|| !in->get_vector(&edge_weights)) {
+		return false;
+	}
+	triangles_local_map_.reserve(local_counts.size());
+	triangles_local_map_.insert(local_counts.begin(), local_counts.end());
+	triangles_weight_local_map_.reserve(local_weights.size());
+	triangles_weight_local_map_.insert(local_weights.begin(), local_weights.end());
+	edge_weight_.insert(edge_weights.begin(), edge_weights.end());
+
+	if (with_sample) {
+		vector<pair<int, int>> sample;
+		if (!in->get_vector(&sample)) {
+			return false;
+		}
+		edge_slots_.reserve(sample.size());
+		for (const auto& edge: sample) {
+			add_edge_sample(edge.first, edge.second);
+		}
+	}
+	return true;
+}
+
 unsigned long long int TriangleCounter::edges_present_original() const {
 	return edges_present_original_;
 }
 
 int TriangleCounter::common_neighbors(const int u, const int v) const {
+	PROFILE_PHASE(PHASE_PROBE);
 	int min_deg_n = (graph_.degree(u) <= graph_.degree(v) ? u : v);
 	int max_deg_n = (graph_.degree(u) <= graph_.degree(v) ? v : u);
 
 	vector<int> min_neighbors;
 	graph_.neighbors(min_deg_n, & min_neighbors);
+	PROFILE_COUNT(EVENT_NEIGHBORS_SCANNED, min_neighbors.size());
 
 	//unordered_set<int> min_set(min_neighbors.begin(), min_neighbors.end());
   //vector<int> max_neighbors;
@@ -168,7 +261,8 @@ int TriangleCounter::common_neighbors(const int u, const int v) const {
 	int ret = 0;
 	for(const auto& n : min_neighbors){
 		if(n!= max_deg_n){
-			if(set_edge_ids_.find(edge_to_id(n, max_deg_n)) != set_edge_ids_.end()){
+			PROFILE_COUNT(EVENT_EDGE_PROBES, 1);
+			if(edge_slots_.find(edge_to_id(n, max_deg_n)) != edge_slots_.end()){
 				ret++;
 			}
 		}
@@ -4,14 +4,29 @@
 
 #include "GraphScheduler.h"
 #include "UDynGraph.h"
+#include "Snapshot.h"
+#include "Profile.h"
+#include "MemoryUsage.h"
+
+#include <functional>
+#include <cassert>
+
+
+// splitmix64 finalizer
+inline unsigned long long mix64(unsigned long long x){
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
 
-
-// hashing pairs
+// hashing pairs (both orders of the same nodes have different hashes)
 namespace std {
 	template <> struct hash<std::pair<int, int>> {
   	inline size_t operator()(const std::pair<int, int> &v) const {
-    	std::hash<int> int_hasher;
-    	return int_hasher(v.first) ^ int_hasher(v.second);
+    	return mix64(((unsigned long long)(unsigned int)v.first << 32) | (unsigned int)v.second);
   	}
 	};
 }
@@ -41,14 +56,41 @@ public:
 
 	void clear();
 
-	// Add or remove edge from sample (no other operation executed)
-	bool add_edge_sample(const int u, const int v);
+	// Add or remove edge from sample (no other operation executed). The slot
+	// is stored with the edge for the sampler (e.g. its position in the
+	// reservoir), so the sampler needs no index of its own.
+	bool add_edge_sample(const int u, const int v, const int slot = -1);
 	bool remove_edge_sample(const int u, const int v);
+	// Number of edges added to or removed from the sample so far
+	inline unsigned long long sample_changes() const {
+		return sample_changes_;
+	}
+	// Slot of the edge, -1 if it is not in the sample (or has no slot)
+	inline int edge_slot(const int u, const int v) const {
+		PROFILE_COUNT(EVENT_EDGE_PROBES, 1);
+		auto it = edge_slots_.find(edge_to_id(u,v));
+		return it == edge_slots_.end() ? -1 : it->second;
+	}
+	inline void set_edge_slot(const int u, const int v, const int slot){
+		assert(edge_slots_.find(edge_to_id(u,v)) != edge_slots_.end());
+		edge_slots_[edge_to_id(u,v)] = slot;
+	}
 	// Increments the counters of seen edges
 	void new_update(const EdgeUpdate& update);
 	// Increase or decrease the triangles (notice the sample is not affected)
 	void add_triangles(const int u, const int v, double weight);
+	// As above, the weight of triangle (u,v,n) is wedge_weight(n) (it can depend
+	// on the edges (u,n) and (v,n) of the sample).
+	void add_triangles(const int u, const int v, const function<double(int)>& wedge_weight);
 	void remove_triangles(const int u, const int v, double weight);
+	// Subtracts only the weight of the triangles, global and local, leaving
+	// the counts alone: for estimators (ThinkD) that count on deletions the
+	// triangles of the sample, which may be more than were counted when the
+	// edges were added, so that the weights can go (correctly) below 0.
+	// Returns the number of triangles of the sample with u and v.
+	int remove_triangles_weight(const int u, const int v, double weight);
+	// Number of triangles u,v,n of the sample (with u,v in the sample or not)
+	int common_neighbors(const int u, const int v) const;
 
 	unsigned long long int edges_present_original() const;
 
@@ -89,6 +131,16 @@ public:
 		edge_weight_.erase(make_pair(v,u));
 	}
 
+	// Estimated heap bytes used by the sample and the counters
+	size_t memory_bytes() const;
+	// Adds the bytes of the graph, edge index, local counts and edge weights
+	void memory_usage(MemoryUsage* usage) const;
+
+	// Counters and (if with_sample) the edges of the sample. Without them the
+	// caller adds the sample edges back after load.
+	void save(SnapshotWriter* out, bool with_sample) const;
+	bool load(SnapshotReader* in, bool with_sample);
+
 	void get_nodes(vector<int>*nodes_v){
 		nodes_v->clear();
 		graph_.nodes(nodes_v);
@@ -97,10 +149,16 @@ public:
 private:
 	bool local_;
 
-	int common_neighbors(const int u, const int v) const;
+	// Calls f(n) for each node n closing a triangle u,v,n in the sample
+	template <class F>
+	void for_each_triangle(const int u, const int v, F f);
+	// Weight of triangle u,v,n: weight, or the product of the edge weights
+	double triangle_weight(const int u, const int v, const int n, double weight);
+	// Adds the triangle u,v,n with the weight to the global and local counts
+	void count_triangle(const int u, const int v, const int n, double weight);
 	UDynGraph graph_;
 
-	unordered_set<unsigned long long> set_edge_ids_;//used for fast lookup of x,y edge
+	unordered_map<unsigned long long, int> edge_slots_;// edge id -> slot, used for fast lookup of x,y edge
 
 	unsigned long long int triangles_;
 	double triangles_weight_;
@@ -109,6 +167,8 @@ private:
 	unordered_map<int, double> triangles_weight_local_map_;
 
 
+	unsigned long long sample_changes_;
+
 	unsigned long long int edges_present_original_; // count of current edges in
 	//the original graph (not in the sampled graph).
 
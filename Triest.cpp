@@ -0,0 +1,245 @@
+#include "Triest.h"
+#include "GraphSampler.h"
+#include "TriangleCounter.h"
+#include "SamplerEnsemble.h"
+
+#include <vector>
+
+using namespace std;
+
+struct TriestState {
+	TriestConfig config;
+	TriangleCounter counter; // unused by an ensemble, which has its own
+	GraphSampler* sampler;
+	vector<EdgeUpdate> batch;
+	unsigned long long num_updates;
+
+	explicit TriestState(const TriestConfig& config) :
+			config(config), counter(config.local != 0), sampler(NULL), num_updates(0) {
+	}
+	~TriestState() {
+		delete sampler;
+	}
+};
+
+static bool valid_config(const TriestConfig& config) {
+	if (config.num_instances < 1 || (config.type == TRIEST_EXACT && config.num_instances > 1)) {
+		return false;
+	}
+	switch (config.type) {
+	case TRIEST_RESERVOIR:
+	case TRIEST_RESERVOIR_FD:
+	case TRIEST_THINKD:
+	case TRIEST_COORDINATED:
+		return config.size > 0;
+	case TRIEST_FIXED_P:
+		return config.p > 0 && config.p <= 1;
+	case TRIEST_WAITING_ROOM:
+		return config.size > 0 && config.waiting_room_fraction >= 0 && config.waiting_room_fraction < 1;
+	case TRIEST_SLIDING_WINDOW:
+		return config.size > 0 && config.window_length > 0;
+	case TRIEST_EXACT:
+		return true;
+	}
+	return false;
+}
+
+static bool insertion_only(triest_sampler_type type) {
+	return type == TRIEST_RESERVOIR || type == TRIEST_WAITING_ROOM
+			|| type == TRIEST_COORDINATED || type == TRIEST_SLIDING_WINDOW;
+}
+
+// The instances of an ensemble are seeded with seed, seed+1, ... so the
+// estimates do not depend on srand() in the caller.
+static GraphSampler* make_sampler(const TriestConfig& config, unsigned int seed, TriangleCounter* counter) {
+	GraphSampler* sampler = NULL;
+	bool sample_and_hold = config.sample_and_hold != 0;
+	switch (config.type) {
+	case TRIEST_RESERVOIR:
+		sampler = new ReservoirSampler(config.size, sample_and_hold, counter);
+		break;
+	case TRIEST_RESERVOIR_FD:
+		sampler = new ReservoirAddRemSampler(config.size, counter);
+		break;
+	case TRIEST_FIXED_P:
+		sampler = new FixedPSampler(config.p, sample_and_hold, counter);
+		break;
+	case TRIEST_THINKD:
+		sampler = new ThinkDSampler(config.size, counter);
+		break;
+	case TRIEST_WAITING_ROOM:
+		sampler = new WaitingRoomSampler(config.size, config.waiting_room_fraction, counter);
+		break;
+	case TRIEST_COORDINATED:
+		sampler = new CoordinatedSampler(config.size, seed, counter);
+		break;
+	case TRIEST_SLIDING_WINDOW:
+		sampler = new SlidingWindowSampler(config.size, config.window_length, counter);
+		break;
+	case TRIEST_EXACT:
+		sampler = new ExactSampler(config.local != 0);
+		break;
+	}
+	sampler->seed(seed);
+	return sampler;
+}
+
+static bool valid_update(const TriestConfig& config, const TriestUpdate& update) {
+	return update.node_u != update.node_v
+			&& update.node_u >= 0 && update.node_u < MAX_NUM_NODES
+			&& update.node_v >= 0 && update.node_v < MAX_NUM_NODES
+			&& (update.is_add || !insertion_only(config.type));
+}
+
+static inline EdgeUpdate to_edge_update(const TriestUpdate& update) {
+	EdgeUpdate edge_update = {update.node_u, update.node_v, update.time, update.is_add != 0};
+	return edge_update;
+}
+
+TriestCounter* TriestCounter::create(const TriestConfig& config) {
+	if (!valid_config(config)) {
+		return NULL;
+	}
+	TriestState* state = new TriestState(config);
+	if (config.num_instances == 1) {
+		state->sampler = make_sampler(config, config.seed, &state->counter);
+	} else {
+		unsigned int instance = 0;
+		state->sampler = new SamplerEnsemble(config.num_instances, config.local != 0,
+				[&](TriangleCounter* counter) {
+			return make_sampler(config, config.seed + instance++, counter);
+		});
+	}
+	return new TriestCounter(state);
+}
+
+TriestConfig TriestCounter::default_config() {
+	TriestConfig config;
+	config.type = TRIEST_RESERVOIR;
+	config.size = 100000;
+	config.p = 0.1;
+	config.sample_and_hold = 0;
+	config.waiting_room_fraction = 0.1;
+	config.window_length = 0;
+	config.local = 0;
+	config.seed = 1;
+	config.num_instances = 1;
+	return config;
+}
+
+TriestCounter::TriestCounter(TriestState* state) : state_(state) {
+}
+
+TriestCounter::~TriestCounter() {
+	delete state_;
+}
+
+bool TriestCounter::add_edge(int node_u, int node_v) {
+	TriestUpdate edge = {node_u, node_v, 0, 1};
+	return update(edge);
+}
+
+bool TriestCounter::remove_edge(int node_u, int node_v) {
+	TriestUpdate edge = {node_u, node_v, 0, 0};
+	return update(edge);
+}
+
+bool TriestCounter::update(const TriestUpdate& update) {
+	if (!valid_update(state_->config, update)) {
+		return false;
+	}
+	state_->sampler->exec_operation(to_edge_update(update));
+	state_->num_updates++;
+	return true;
+}
+
+size_t TriestCounter::push_batch(const TriestUpdate* updates, size_t num_updates) {
+	vector<EdgeUpdate>& batch = state_->batch;
+	batch.clear();
+	for (size_t i = 0; i < num_updates && valid_update(state_->config, updates[i]); i++) {
+		batch.push_back(to_edge_update(updates[i]));
+	}
+	state_->sampler->exec_batch(batch);
+	state_->num_updates += batch.size();
+	return batch.size();
+}
+
+double TriestCounter::global_estimate() {
+	return state_->sampler->get_triangle_est();
+}
+
+double TriestCounter::local_estimate(int node) {
+	if (!state_->config.local) {
+		return -1;
+	}
+	return state_->sampler->get_triangle_est_local(node);
+}
+
+unsigned long long TriestCounter::num_updates() const {
+	return state_->num_updates;
+}
+
+size_t TriestCounter::memory_bytes() const {
+	MemoryUsage usage;
+	state_->sampler->memory_usage(&usage);
+	return usage.total();
+}
+
+// C API
+
+struct triest_counter {
+	TriestCounter* counter;
+};
+
+void triest_default_config(triest_config* config) {
+	*config = TriestCounter::default_config();
+}
+
+triest_counter* triest_new(const triest_config* config) {
+	TriestCounter* counter = config != NULL ? TriestCounter::create(*config) : NULL;
+	if (counter == NULL) {
+		return NULL;
+	}
+	triest_counter* handle = new triest_counter;
+	handle->counter = counter;
+	return handle;
+}
+
+void triest_free(triest_counter* counter) {
+	if (counter != NULL) {
+		delete counter->counter;
+		delete counter;
+	}
+}
+
+int triest_add_edge(triest_counter* counter, int node_u, int node_v) {
+	return counter->counter->add_edge(node_u, node_v);
+}
+
+int triest_remove_edge(triest_counter* counter, int node_u, int node_v) {
+	return counter->counter->remove_edge(node_u, node_v);
+}
+
+int triest_update_edge(triest_counter* counter, const triest_update* update) {
+	return counter->counter->update(*update);
+}
+
+size_t triest_push_batch(triest_counter* counter, const triest_update* updates, size_t num_updates) {
+	return counter->counter->push_batch(updates, num_updates);
+}
+
+double triest_global_estimate(triest_counter* counter) {
+	return counter->counter->global_estimate();
+}
+
+double triest_local_estimate(triest_counter* counter, int node) {
+	return counter->counter->local_estimate(node);
+}
+
+unsigned long long triest_num_updates(const triest_counter* counter) {
+	return counter->counter->num_updates();
+}
+
+size_t triest_memory_bytes(const triest_counter* counter) {
+	return counter->counter->memory_bytes();
+}
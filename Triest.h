@@ -0,0 +1,46 @@
+#ifndef TRIEST_H_
+#define TRIEST_H_
+
+#include "TriestC.h"
+
+#include <cstddef>
+
+typedef triest_config TriestConfig;
+typedef triest_update TriestUpdate;
+
+struct TriestState;
+
+// C++ API of libtriest, same types and rules as the C one (TriestC.h). The
+// sampler classes are behind a pointer, so the callers only depend on this
+// header and on TriestC.h.
+class TriestCounter {
+public:
+	// NULL if the configuration is not valid (the caller owns the counter)
+	static TriestCounter* create(const TriestConfig& config);
+	static TriestConfig default_config();
+	~TriestCounter();
+
+	// False (update not executed) for a loop, a node id out of range or a
+	// deletion with an insertion only sampler.
+	bool add_edge(int node_u, int node_v);
+	bool remove_edge(int node_u, int node_v);
+	bool update(const TriestUpdate& update);
+	// Number of updates executed, up to the first one not valid. The updates
+	// of a batch are run in parallel by the instances of an ensemble.
+	size_t push_batch(const TriestUpdate* updates, size_t num_updates);
+
+	double global_estimate();
+	// -1 if the counter does not keep the local counts
+	double local_estimate(int node);
+	unsigned long long num_updates() const;
+	size_t memory_bytes() const;
+
+private:
+	explicit TriestCounter(TriestState* state);
+	TriestCounter(const TriestCounter&);
+	TriestCounter& operator=(const TriestCounter&);
+
+	TriestState* state_;
+};
+
+#endif /* TRIEST_H_ */
@@ -0,0 +1,78 @@
+#ifndef TRIESTC_H_
+#define TRIESTC_H_
+
+/*
+ * C API of libtriest (see Triest.h for the C++ one): a sampler built from a
+ * triest_config and fed with the updates of the stream in process, one at a
+ * time or in batches. No file is read or written and nothing is printed.
+ * A counter must not be used by two threads at the same time.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	TRIEST_RESERVOIR, /* TRIEST-BASE (TRIEST-IMPR with sample_and_hold), insertion only */
+	TRIEST_RESERVOIR_FD, /* TRIEST-FD, fully dynamic */
+	TRIEST_FIXED_P, /* each edge kept with prob p, fully dynamic */
+	TRIEST_THINKD, /* ThinkD, fully dynamic */
+	TRIEST_WAITING_ROOM, /* waiting room sampling, insertion only */
+	TRIEST_COORDINATED, /* reservoir by edge hash, insertion only */
+	TRIEST_SLIDING_WINDOW, /* reservoir on the edges of the last window_length time units, insertion only */
+	TRIEST_EXACT /* exact counts, fully dynamic, no sampling */
+} triest_sampler_type;
+
+typedef struct {
+	triest_sampler_type type;
+	size_t size; /* reservoir size (memory size for the waiting room) */
+	double p; /* TRIEST_FIXED_P */
+	int sample_and_hold; /* TRIEST_RESERVOIR and TRIEST_FIXED_P */
+	double waiting_room_fraction; /* TRIEST_WAITING_ROOM */
+	int window_length; /* TRIEST_SLIDING_WINDOW, in the time units of the updates */
+	int local; /* keeps the local counts, for triest_local_estimate */
+	unsigned int seed; /* the estimates depend only on the seed and the updates */
+	size_t num_instances; /* independent instances averaged (1 = a single sampler) */
+} triest_config;
+
+typedef struct {
+	int node_u;
+	int node_v;
+	int time; /* only used by TRIEST_SLIDING_WINDOW */
+	int is_add; /* 1 = addition, 0 = deletion */
+} triest_update;
+
+typedef struct triest_counter triest_counter;
+
+/* Reservoir of 100000 edges, insertion only, global count, seed 1 */
+void triest_default_config(triest_config* config);
+
+/* NULL if the configuration is not valid */
+triest_counter* triest_new(const triest_config* config);
+void triest_free(triest_counter* counter);
+
+/*
+ * The updates follow the stream model of the samplers: an edge is added only
+ * when not in the graph and deleted only when in it. Return 0 (update not
+ * executed) for a loop, a node id out of range, or a deletion with an
+ * insertion only sampler.
+ */
+int triest_add_edge(triest_counter* counter, int node_u, int node_v);
+int triest_remove_edge(triest_counter* counter, int node_u, int node_v);
+int triest_update_edge(triest_counter* counter, const triest_update* update);
+/* Number of updates executed, up to the first one not valid */
+size_t triest_push_batch(triest_counter* counter, const triest_update* updates, size_t num_updates);
+
+double triest_global_estimate(triest_counter* counter);
+/* -1 if the counter does not keep the local counts */
+double triest_local_estimate(triest_counter* counter, int node);
+unsigned long long triest_num_updates(const triest_counter* counter);
+size_t triest_memory_bytes(const triest_counter* counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRIESTC_H_ */
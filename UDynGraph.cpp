@@ -1,23 +1,26 @@
 #include "UDynGraph.h"
+#include "MemoryUsage.h"
+#include "Profile.h"
 #include <iostream>
 #include <cassert>
 #include <algorithm>
 
 UDynGraph::UDynGraph() :
-        num_nodes_(0), num_edges_(0) {
+        num_nodes_(0), num_edges_(0), adjacency_bytes_(0) {
 }
 
 UDynGraph::~UDynGraph() {
 }
 
 void UDynGraph::clear() {
-    nodes_.clear();
     node_map_.clear();
     num_nodes_ = 0;
     num_edges_ = 0;
+    adjacency_bytes_ = 0;
 }
 
 bool UDynGraph::add_edge(const int source, const int destination) {
+    PROFILE_PHASE(PHASE_ADJACENCY);
     assert(source != destination);
     assert(source >= 0);
     assert(destination >= 0);
@@ -31,22 +34,37 @@ bool UDynGraph::add_edge(const int source, const int destination) {
 
     ++num_edges_;
 
-    if (nodes_.find(source) == nodes_.end()) {
-        nodes_.insert(source);
-        ++num_nodes_;
-    }
-    if (nodes_.find(destination) == nodes_.end()) {
-        nodes_.insert(destination);
+    add_neighbor(destination, source);
+    add_neighbor(source, destination);
+
+    return true;
+}
+
+void UDynGraph::add_neighbor(const int u, const int v) {
+    vector<int>& vec = node_map_[u];
+    if (vec.empty()) { // new node
         ++num_nodes_;
     }
+    size_t before = vector_bytes(vec);
+    vec.push_back(v);
+    adjacency_bytes_ += vector_bytes(vec) - before;
+}
 
-    node_map_[destination].push_back(source);
-    node_map_[source].push_back(destination);
-
-    return true;
+void UDynGraph::remove_neighbor(const int u, const int v) {
+    auto it = node_map_.find(u);
+    vector<int>& vec = it->second;
+    if (vec.size() == 1) {
+        adjacency_bytes_ -= vector_bytes(vec);
+        node_map_.erase(it);
+        --num_nodes_;
+    } else {
+        *std::find(vec.begin(), vec.end(), v) = vec[vec.size() - 1];
+        vec.resize(vec.size() - 1);
+    }
 }
 
 bool UDynGraph::remove_edge(const int source, const int destination) {
+    PROFILE_PHASE(PHASE_ADJACENCY);
 
     if (node_map_.find(source) == node_map_.end()) {
         return false;
@@ -59,26 +77,8 @@ bool UDynGraph::remove_edge(const int source, const int destination) {
 
     --num_edges_;
 
-    if (node_map_[source].size() == 1) {
-        node_map_.erase(source);
-        --num_nodes_;
-    } else {
-
-        *std::find(node_map_[source].begin(), node_map_[source].end(),
-                destination) = node_map_[source][node_map_[source].size() - 1];
-        node_map_[source].resize(node_map_[source].size() - 1);
-    }
-
-    if (node_map_[destination].size() == 1) {
-        node_map_.erase(destination);
-        --num_nodes_;
-    } else {
-
-        *std::find(node_map_[destination].begin(), node_map_[destination].end(),
-                source) = node_map_[destination][node_map_[destination].size()
-                - 1];
-        node_map_[destination].resize(node_map_[destination].size() - 1);
-    }
+    remove_neighbor(source, destination);
+    remove_neighbor(destination, source);
 
     return true;
 }
@@ -87,6 +87,10 @@ int UDynGraph::num_edges() const {
     return num_edges_;
 }
 
+size_t UDynGraph::memory_bytes() const {
+    return hashed_bytes(node_map_) + adjacency_bytes_;
+}
+
 int UDynGraph::num_nodes() const {
     return num_nodes_;
 }
@@ -101,7 +105,9 @@ void UDynGraph::neighbors(const int source, vector<int>* vec) const {
 
 void UDynGraph::nodes(vector<int>* vec) const {
     vec->clear();
-    vec->assign(nodes_.begin(), nodes_.end());
+    for (const auto& v_pair : node_map_) {
+        vec->push_back(v_pair.first);
+    }
 }
 
 int UDynGraph::degree(const int source) const {
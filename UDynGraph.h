@@ -20,19 +20,26 @@ public:
     void neighbors(const int u, vector<int>* vec) const;
     int degree(const int u) const;
     void edges(vector<pair<int, int> >* vec) const;
+    // Nodes with at least one edge
     void nodes(vector<int>* vec) const;
     void clear();
     int num_nodes() const;
     int num_edges() const;
+    // Estimated heap bytes used by the graph
+    size_t memory_bytes() const;
 
     UDynGraph();
     virtual ~UDynGraph();
 private:
-    unordered_map<int, vector<int> > node_map_;
-    unordered_set<int> nodes_;
+    unordered_map<int, vector<int> > node_map_; // only the nodes with edges
+
+    // Appends to / removes from the adjacency of u, keeping adjacency_bytes_
+    void add_neighbor(const int u, const int v);
+    void remove_neighbor(const int u, const int v);
 
     int num_nodes_;
     int num_edges_;
+    size_t adjacency_bytes_; // heap bytes of the vectors in node_map_
 };
 
 #endif /* UDYNGRAPHMEMEFF_H_ */